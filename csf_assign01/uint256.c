@@ -1,89 +1,289 @@
 #include <assert.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include "uint256.h"
+#include "uint256_inline.h"
+
+// Compute left*right + addend1 + addend2 as a 128-bit value, returning the
+// low 64 bits and storing the high 64 bits in *hi. This can never overflow,
+// since (2^64-1)^2 + 2*(2^64-1) = 2^128-1.
+static inline uint64_t uint256_mul64_add(uint64_t left, uint64_t right, uint64_t addend1, uint64_t addend2, uint64_t *hi) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 u128;
+  u128 prod = (u128) left * right + addend1 + addend2;
+  *hi = (uint64_t) (prod >> 64);
+  return (uint64_t) prod;
+#else
+  // build the 128-bit product out of four 32x32->64 partial products
+  uint64_t left_lo = (uint32_t) left, left_hi = left >> 32;
+  uint64_t right_lo = (uint32_t) right, right_hi = right >> 32;
+  uint64_t p0 = left_lo * right_lo;
+  uint64_t p1 = left_lo * right_hi;
+  uint64_t p2 = left_hi * right_lo;
+  uint64_t p3 = left_hi * right_hi;
+  uint64_t mid = (p0 >> 32) + (uint32_t) p1 + (uint32_t) p2;
+  uint64_t lo = (mid << 32) | (uint32_t) p0;
+  uint64_t high = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+  lo += addend1;
+  high += lo < addend1;
+  lo += addend2;
+  high += lo < addend2;
+  *hi = high;
+  return lo;
+#endif
+}
 
 // Create a UInt256 value from a single uint32_t value.
 // Only the least-significant 32 bits are initialized directly,
 // all other bits are set to 0.
 UInt256 uint256_create_from_u32(uint32_t val) {
-  UInt256 result;
-  result.data[0] = val;
-  for (int x = 1; x < 8; x++) {
-    result.data[x] = 0;
-  }
-  return result;
+  return uint256_inline_create_from_u32(val);
 }
 
 // Create a UInt256 value from an array of NWORDS uint32_t values.
 // The element at index 0 is the least significant, and the element
 // at index 3 is the most significant.
 UInt256 uint256_create(const uint32_t data[8]) {
-  UInt256 result;
-  for (int x = 0; x < 8; x++) {
-    result.data[x] = data[x];
+  return uint256_inline_create(data);
+}
+
+// Value of each hex digit character plus one, so that 0 marks a character
+// that isn't a hex digit.
+static const unsigned char hex_digit_values[256] = {
+  ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+  ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+  ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+  ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+// Hex digit character for each nibble value.
+static const char hex_digit_chars[16] = {
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+// Value of the group of at most 8 characters at chunk, read the way
+// strtoul(chunk, NULL, 16) reads it: leading whitespace, an optional sign
+// and 0x prefix, then hex digits up to the first character that isn't one.
+static uint32_t uint256_hex_chunk_value(const char *chunk, size_t n) {
+  size_t i = 0;
+  while (i < n && isspace((unsigned char) chunk[i])) {
+    i++;
   }
-  return result;
+  int negative = 0;
+  if (i < n && (chunk[i] == '+' || chunk[i] == '-')) {
+    negative = chunk[i] == '-';
+    i++;
+  }
+  // "0x" only counts as a prefix if a digit follows; otherwise the 0 is the number
+  if (i + 2 < n && chunk[i] == '0' && (chunk[i + 1] == 'x' || chunk[i + 1] == 'X') &&
+      hex_digit_values[(unsigned char) chunk[i + 2]] != 0) {
+    i += 2;
+  }
+  uint32_t value = 0;
+  for (unsigned char code; i < n && (code = hex_digit_values[(unsigned char) chunk[i]]) != 0; i++) {
+    value = (value << 4) | (uint32_t) (code - 1);
+  }
+  return negative ? 0U - value : value;
 }
 
 // Create a UInt256 value from a string of hexadecimal digits.
 UInt256 uint256_create_from_hex(const char *hex) {
-  UInt256 result;
-  int len = strlen(hex);
-  int index = 0;
-  // keep counting hex digits until we have full 8 blocks or we have read all available chars
-  while (index != 8 && len >= 0) {
-    int digits_to_read = len >= 8 ? 8 : len;
-    // sets pointer to first letter of last chunk we still need to read in hex string
-    const char* chunk = hex + (len - digits_to_read);
-    // account for null terminator
-    char* read = malloc(9*sizeof(char)); 
-    strncpy(read, chunk, digits_to_read);
-     // explicity set null terminator
-    read[digits_to_read] = '\0';
-    result.data[index] = strtoul(read, NULL, 16);
-    free(read);
-    index++;
-    len -= 8;
-  }
-
-  // if not all indexes have been initialized, make the remaining ones zero
-  while (index != 8) {
-    result.data[index] = 0;
-    index++;
+  UInt256 result = uint256_create_from_u32(0);
+  // each 32-bit word comes from a group of 8 characters, counting from the
+  // right; characters before the rightmost 64 are ignored
+  size_t len = strlen(hex);
+  for (unsigned index = 0; index < 8 && len > 0; index++) {
+    size_t n = len >= 8 ? 8 : len;
+    len -= n;
+    result.data[index] = uint256_hex_chunk_value(hex + len, n);
   }
   return result;
 }
 
+// Parse the len hexadecimal digits starting at hex into *result.
+int uint256_parse_hex_n(const char *hex, size_t len, UInt256 *result) {
+  UInt256 val = uint256_create_from_u32(0);
+  unsigned char bad = 0;
+  // only the rightmost 64 digits fit, but every digit still has to be valid
+  size_t skip = len > 64 ? len - 64 : 0;
+  for (size_t i = 0; i < skip; i++) {
+    bad |= hex_digit_values[(unsigned char) hex[i]] == 0;
+  }
+  // walk from the least significant digit, four bits at a time
+  const char *digit = hex + len;
+  for (unsigned pos = 0; pos < len - skip; pos++) {
+    unsigned char code = hex_digit_values[(unsigned char) *--digit];
+    bad |= code == 0;
+    val.data[pos / 8] |= (uint32_t) ((code - 1) & 0xF) << (4 * (pos % 8));
+  }
+  if (bad) {
+    *result = uint256_create_from_u32(0);
+    return UINT256_ERR_INVALID_DIGIT;
+  }
+  *result = val;
+  return UINT256_OK;
+}
+
 // Return a dynamically-allocated string of hex digits representing the
 // given UInt256 value.
 char *uint256_format_as_hex(UInt256 val) {
-  // if val is zero, just return zero
-  if (isZero(val)) {
-    char *hex = malloc(2*sizeof(char));
-    hex[0] = '0';
-    hex[1] = '\0';
-    return hex;
-  }
-  char *hex = malloc(65*sizeof(char));
-  memset(hex, '\0', sizeof(char));
-  // temp pointer to hex that allows us to build string and then return hex, which points to the front
-  char *hex_temp = hex;
-  for (int i = 7; i >= 0; i--) {
-    uint32_t cur_val = val.data[i];
-    char buf[9];
-    memset(buf, 0, sizeof(buf));
-    // leading zeros ok since we truncate at the end
-    sprintf(buf, "%08x", cur_val);
-    strcpy(hex_temp, buf);
-    hex_temp += strlen(buf);
-  }
-  trimLeadingZeros(hex);
+  char buf[65];
+  size_t len = uint256_format_hex_into(val, buf);
+  char *hex = malloc(len + 1);
+  memcpy(hex, buf, len + 1);
   return hex;
 }
 
+// Write the hex digits of val into out, with no leading zeros.
+size_t uint256_format_hex_into(UInt256 val, char out[65]) {
+  // find the most significant nonzero word
+  int top = 7;
+  while (top > 0 && val.data[top] == 0) {
+    top--;
+  }
+  // number of significant digits in the top word (a zero value still gets one digit)
+  uint32_t top_word = val.data[top];
+  unsigned top_digits = 1;
+  while (top_digits < 8 && (top_word >> (4 * top_digits)) != 0) {
+    top_digits++;
+  }
+
+  char *pos = out;
+  for (int shift = 4 * (top_digits - 1); shift >= 0; shift -= 4) {
+    *pos++ = hex_digit_chars[(top_word >> shift) & 0xF];
+  }
+  // every word below the top one is written out as exactly 8 digits
+  for (int i = top - 1; i >= 0; i--) {
+    uint32_t word = val.data[i];
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      *pos++ = hex_digit_chars[(word >> shift) & 0xF];
+    }
+  }
+  *pos = '\0';
+  return (size_t) (pos - out);
+}
+
+// 10^19 is the largest power of ten that fits in 64 bits, so decimal
+// conversion moves 19 digits at a time through a single wide operation.
+#define DEC_CHUNK_DIGITS 19
+#define DEC_CHUNK_BASE 10000000000000000000ULL
+
+// Set *val = *val * mul + add, returning the 64 bits that overflowed.
+static uint64_t uint256_mul_u64_add(UInt256 *val, uint64_t mul, uint64_t add) {
+  uint64_t carry = add;
+  for (unsigned x = 0; x < 4; x++) {
+    uint256_store_u64(val, x, uint256_mul64_add(uint256_load_u64(val, x), mul, carry, 0, &carry));
+  }
+  return carry;
+}
+
+// Divide *val by divisor in place, returning the remainder.
+static uint64_t uint256_div_u64(UInt256 *val, uint64_t divisor) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 u128;
+  uint64_t rem = 0;
+  for (int x = 3; x >= 0; x--) {
+    u128 cur = ((u128) rem << 64) | uint256_load_u64(val, x);
+    uint256_store_u64(val, x, (uint64_t) (cur / divisor));
+    rem = (uint64_t) (cur % divisor);
+  }
+  return rem;
+#else
+  UInt256 den = uint256_create_from_u32(0), rem;
+  uint256_store_u64(&den, 0, divisor);
+  uint256_divmod(*val, den, val, &rem);
+  return uint256_load_u64(&rem, 0);
+#endif
+}
+
+// Create a UInt256 value from a string of decimal digits.
+UInt256 uint256_create_from_dec(const char *dec) {
+  UInt256 result;
+  // invalid or too large strings leave result set to zero
+  uint256_parse_dec_n(dec, strlen(dec), &result);
+  return result;
+}
+
+// Parse the len decimal digits starting at dec into *result.
+int uint256_parse_dec_n(const char *dec, size_t len, UInt256 *result) {
+  UInt256 val = uint256_create_from_u32(0);
+  uint64_t overflow = 0;
+  size_t pos = 0;
+  // the first chunk takes the leftover digits so the rest are full chunks
+  size_t chunk_len = len % DEC_CHUNK_DIGITS;
+  if (chunk_len == 0) {
+    chunk_len = DEC_CHUNK_DIGITS;
+  }
+  while (pos < len) {
+    uint64_t chunk = 0, scale = 1;
+    for (size_t i = 0; i < chunk_len; i++) {
+      unsigned digit = (unsigned char) dec[pos + i] - '0';
+      if (digit > 9) {
+        *result = uint256_create_from_u32(0);
+        return UINT256_ERR_INVALID_DIGIT;
+      }
+      chunk = chunk * 10 + digit;
+      scale *= 10;
+    }
+    overflow |= uint256_mul_u64_add(&val, scale, chunk);
+    pos += chunk_len;
+    chunk_len = DEC_CHUNK_DIGITS;
+  }
+  if (overflow) {
+    *result = uint256_create_from_u32(0);
+    return UINT256_ERR_OVERFLOW;
+  }
+  *result = val;
+  return UINT256_OK;
+}
+
+// Return a dynamically-allocated string of decimal digits representing
+// the given UInt256 value.
+char *uint256_format_as_dec(UInt256 val) {
+  char buf[79];
+  size_t len = uint256_format_dec_into(val, buf);
+  char *dec = malloc(len + 1);
+  memcpy(dec, buf, len + 1);
+  return dec;
+}
+
+// Write the decimal digits of val into out, with no leading zeros.
+size_t uint256_format_dec_into(UInt256 val, char out[79]) {
+  // peel off 19-digit chunks from the least significant end
+  uint64_t chunks[5];
+  int num_chunks = 0;
+  do {
+    chunks[num_chunks++] = uint256_div_u64(&val, DEC_CHUNK_BASE);
+  } while (!isZero(val));
+
+  char *pos = out;
+  // the most significant chunk is written without leading zeros
+  char digits[DEC_CHUNK_DIGITS];
+  int ndigits = 0;
+  uint64_t top = chunks[num_chunks - 1];
+  do {
+    digits[ndigits++] = (char) ('0' + top % 10);
+    top /= 10;
+  } while (top != 0);
+  while (ndigits > 0) {
+    *pos++ = digits[--ndigits];
+  }
+  // every other chunk is exactly 19 digits, zero padded
+  for (int c = num_chunks - 2; c >= 0; c--) {
+    uint64_t chunk = chunks[c];
+    for (int i = DEC_CHUNK_DIGITS - 1; i >= 0; i--) {
+      pos[i] = (char) ('0' + chunk % 10);
+      chunk /= 10;
+    }
+    pos += DEC_CHUNK_DIGITS;
+  }
+  *pos = '\0';
+  return (size_t) (pos - out);
+}
+
 // check if 256 bit val is zero
 int isZero(UInt256 val) {
   for (int x = 0; x < 8; x++) {
@@ -113,93 +313,347 @@ void trimLeadingZeros(char *str) {
 // Index 0 is the least significant 32 bits, index 7 is the most
 // significant 32 bits.
 uint32_t uint256_get_bits(UInt256 val, unsigned index) {
-  uint32_t bits; 
-  bits = val.data[index];
-  return bits;
+  return uint256_inline_get_bits(val, index);
 }
 
+// Compute the sum of two UInt256 values.
 UInt256 uint256_add(UInt256 left, UInt256 right) {
-  UInt256 sum;
-  uint32_t carry = 0;
-  for (int x = 0; x < 8; x++) {
-    uint32_t left_val = left.data[x];
-    uint32_t right_val = right.data[x]; 
-    uint32_t cur_sum = left_val + right_val + carry;
-    sum.data[x] = (uint32_t)(cur_sum);
-    // if cur_sum < left_val, we have overflow and need to carry
-    if (cur_sum < left_val) {
-      carry = 1;
-    }
-    // if cur_sum is same as left_val, we keep carry the exact same as it was for next block
-    else if (cur_sum == left_val) {
-      continue;
-    }
-    // if cur_sum > left_val, addition was normal and carry can return to zero
-    else {
-      carry = 0;
-    }
-  }
-  return sum;
+  return uint256_inline_add(left, right);
 }
 
 // Compute the difference of two UInt256 values.
 UInt256 uint256_sub(UInt256 left, UInt256 right) {
-  UInt256 result;
-  UInt256 negated_right = uint256_negate(right);
-  result = uint256_add(left, negated_right);
-  return result;
+  return uint256_inline_sub(left, right);
 }
+
 // Return the two's-complement negation of the given UInt256 value.
 UInt256 uint256_negate(UInt256 val) {
+  return uint256_inline_negate(val);
+}
+
+// Compute the product of two UInt256 values. Only the least
+// significant 256 bits of the product are kept.
+UInt256 uint256_mul(UInt256 left, UInt256 right) {
+  uint64_t a[4], b[4], prod[4] = {0, 0, 0, 0};
+  for (unsigned x = 0; x < 4; x++) {
+    a[x] = uint256_load_u64(&left, x);
+    b[x] = uint256_load_u64(&right, x);
+  }
+  // schoolbook multiplication, skipping partial products that land above bit 255
+  for (unsigned i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (unsigned j = 0; i + j < 4; j++) {
+      prod[i + j] = uint256_mul64_add(a[i], b[j], prod[i + j], carry, &carry);
+    }
+  }
   UInt256 result;
-  for (int k = 0; k < 8; k++) {
-    // negate the bits
-    result.data[k] = ~val.data[k];
+  for (unsigned x = 0; x < 4; x++) {
+    uint256_store_u64(&result, x, prod[x]);
+  }
+  return result;
+}
+
+// Compute the full 512-bit product of two UInt256 values.
+UInt512 uint256_mul_wide(UInt256 left, UInt256 right) {
+  uint64_t a[4], b[4], prod[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (unsigned x = 0; x < 4; x++) {
+    a[x] = uint256_load_u64(&left, x);
+    b[x] = uint256_load_u64(&right, x);
+  }
+  for (unsigned i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (unsigned j = 0; j < 4; j++) {
+      prod[i + j] = uint256_mul64_add(a[i], b[j], prod[i + j], carry, &carry);
+    }
+    // the final carry goes into a word no earlier row has touched yet
+    prod[i + 4] = carry;
+  }
+  UInt512 result;
+  for (unsigned x = 0; x < 8; x++) {
+    result.data[2*x] = (uint32_t) prod[x];
+    result.data[2*x + 1] = (uint32_t) (prod[x] >> 32);
   }
-  // add 1 to the negated result
-  result = uint256_add(result, uint256_create_from_u32(1));
   return result;
 }
 
+// Return val shifted left by nbits. Bits shifted past the most
+// significant bit are lost; a shift of 256 or more gives 0.
+UInt256 uint256_shl(UInt256 val, unsigned nbits) {
+  return uint256_inline_shl(val, nbits);
+}
+
+// Return val shifted right by nbits. Bits shifted past the least
+// significant bit are lost; a shift of 256 or more gives 0.
+UInt256 uint256_shr(UInt256 val, unsigned nbits) {
+  return uint256_inline_shr(val, nbits);
+}
+
 // Return the result of rotating every bit in val nbits to
 // the left.  Any bits shifted past the most significant bit
 // should be shifted back into the least significant bits.
 UInt256 uint256_rotate_left(UInt256 val, unsigned nbits) {
-  UInt256 result = val;
-  // if shifting more than 256, just circles back to shifting a small amount (257 = shifting 1 bit)
-  nbits = nbits % 256;
-  int ints_to_shift = nbits / 32;
-  for (int i = 0; i < ints_to_shift; i++) {
-    // temp var to update right most block after index shifts complete
-    uint32_t left_block = result.data[7];
-    for (int k = 7; k > 0; k--) {
-      result.data[k] = result.data[k - 1];
-    }
-    // right most block gets the previous left block value
-    result.data[0] = left_block;
-  }
-
-  // individual bits left that weren't accounted for in index shifts
-  uint32_t leftover_bits = nbits % 32;
-  if (leftover_bits > 0) {
-    uint32_t spill_over = 0;
-    for (int x = 0; x < 8; x++) {
-      uint32_t temp = result.data[x];
-      result.data[x] = (result.data[x] << leftover_bits) | spill_over;
-      // get spill over from old temp value with bits shifted to the right, since spillover 
-      // goes in rightmost positions in the block its shifted to
-      spill_over = temp >> (32-leftover_bits);
-    }
-    // need to update right most block one last time for spill over from left most block
-    result.data[0] = result.data[0] | spill_over;
-  }
-  return result;
+  return uint256_inline_rotate_left(val, nbits);
 }
 
 // Return the result of rotating every bit in val nbits to
 // the right. Any bits shifted past the least significant bit
 // should be shifted back into the most significant bits.
 UInt256 uint256_rotate_right(UInt256 val, unsigned nbits) {
-  nbits = nbits % 256;
-  return uint256_rotate_left(val, 256-nbits);
+  return uint256_inline_rotate_right(val, nbits);
+}
+
+// Compare two UInt256 values, returning -1, 0 or 1.
+int uint256_cmp(UInt256 left, UInt256 right) {
+  return uint256_inline_cmp(left, right);
+}
+
+// Return 1 if left and right are equal, 0 otherwise.
+int uint256_eq(UInt256 left, UInt256 right) {
+  return uint256_inline_eq(left, right);
+}
+
+// Bitwise AND of two UInt256 values.
+UInt256 uint256_and(UInt256 left, UInt256 right) {
+  return uint256_inline_and(left, right);
+}
+
+// Bitwise OR of two UInt256 values.
+UInt256 uint256_or(UInt256 left, UInt256 right) {
+  return uint256_inline_or(left, right);
+}
+
+// Bitwise XOR of two UInt256 values.
+UInt256 uint256_xor(UInt256 left, UInt256 right) {
+  return uint256_inline_xor(left, right);
+}
+
+// Bitwise complement of a UInt256 value.
+UInt256 uint256_not(UInt256 val) {
+  return uint256_inline_not(val);
+}
+
+// Number of leading zero bits in val (256 if val is 0).
+unsigned uint256_clz(UInt256 val) {
+  return uint256_inline_clz(val);
+}
+
+// Number of trailing zero bits in val (256 if val is 0).
+unsigned uint256_ctz(UInt256 val) {
+  return uint256_inline_ctz(val);
+}
+
+// Number of 1 bits in val.
+unsigned uint256_popcount(UInt256 val) {
+  return uint256_inline_popcount(val);
+}
+
+// Divide num by den, storing the quotient in *quot and the remainder in
+// *rem (either may be NULL if it isn't needed).
+int uint256_divmod(UInt256 num, UInt256 den, UInt256 *quot, UInt256 *rem) {
+  // number of significant 32-bit words in the divisor and dividend
+  int n = 8, m = 8;
+  while (n > 0 && den.data[n - 1] == 0) {
+    n--;
+  }
+  if (n == 0) {
+    return UINT256_ERR_DIV_BY_ZERO;
+  }
+  while (m > 0 && num.data[m - 1] == 0) {
+    m--;
+  }
+
+  UInt256 q = uint256_create_from_u32(0);
+  UInt256 r = uint256_create_from_u32(0);
+  if (uint256_inline_cmp(num, den) < 0) {
+    // divisor is bigger, so the quotient is 0
+    r = num;
+  } else if (n == 1) {
+    // single-word divisor: plain short division, one word at a time
+    uint64_t divisor = den.data[0], remainder = 0;
+    for (int i = m - 1; i >= 0; i--) {
+      uint64_t cur = (remainder << 32) | num.data[i];
+      q.data[i] = (uint32_t) (cur / divisor);
+      remainder = cur % divisor;
+    }
+    r.data[0] = (uint32_t) remainder;
+  } else {
+    // Knuth's Algorithm D with 32-bit digits. Normalizing so that the top
+    // bit of the divisor is set makes each estimated quotient digit at most
+    // 2 too large, and the estimate is corrected before it is used.
+    const uint64_t base = (uint64_t) 1 << 32;
+    unsigned s = 0;
+    while ((den.data[n - 1] << s & 0x80000000U) == 0) {
+      s++;
+    }
+    uint32_t vn[8], un[9];
+    for (int i = n - 1; i > 0; i--) {
+      vn[i] = (den.data[i] << s) | (uint32_t) (((uint64_t) den.data[i - 1]) >> (32 - s));
+    }
+    vn[0] = den.data[0] << s;
+    un[m] = (uint32_t) (((uint64_t) num.data[m - 1]) >> (32 - s));
+    for (int i = m - 1; i > 0; i--) {
+      un[i] = (num.data[i] << s) | (uint32_t) (((uint64_t) num.data[i - 1]) >> (32 - s));
+    }
+    un[0] = num.data[0] << s;
+
+    for (int j = m - n; j >= 0; j--) {
+      // estimate the quotient digit from the top two dividend digits
+      uint64_t top = ((uint64_t) un[j + n] << 32) | un[j + n - 1];
+      uint64_t qhat = top / vn[n - 1];
+      uint64_t rhat = top % vn[n - 1];
+      while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+        qhat--;
+        rhat += vn[n - 1];
+        if (rhat >= base) {
+          break;
+        }
+      }
+      // multiply and subtract qhat * divisor from the current dividend digits
+      int64_t borrow = 0, t;
+      for (int i = 0; i < n; i++) {
+        uint64_t p = qhat * vn[i];
+        t = (int64_t) un[i + j] - borrow - (int64_t) (p & 0xFFFFFFFFU);
+        un[i + j] = (uint32_t) t;
+        borrow = (int64_t) (p >> 32) - (t >> 32);
+      }
+      t = (int64_t) un[j + n] - borrow;
+      un[j + n] = (uint32_t) t;
+      q.data[j] = (uint32_t) qhat;
+      // if we subtracted too much (rare), add the divisor back once
+      if (t < 0) {
+        q.data[j]--;
+        uint64_t carry = 0;
+        for (int i = 0; i < n; i++) {
+          uint64_t sum = (uint64_t) un[i + j] + vn[i] + carry;
+          un[i + j] = (uint32_t) sum;
+          carry = sum >> 32;
+        }
+        un[j + n] += (uint32_t) carry;
+      }
+    }
+    // un now holds the normalized remainder, so shift it back down
+    for (int i = 0; i < n; i++) {
+      r.data[i] = (un[i] >> s) | (uint32_t) (((uint64_t) un[i + 1] << 32) >> s);
+    }
+  }
+
+  if (quot != NULL) {
+    *quot = q;
+  }
+  if (rem != NULL) {
+    *rem = r;
+  }
+  return UINT256_OK;
+}
+
+// Return num mod den (0 if den is 0).
+UInt256 uint256_mod(UInt256 num, UInt256 den) {
+  UInt256 rem = uint256_create_from_u32(0);
+  uint256_divmod(num, den, NULL, &rem);
+  return rem;
+}
+
+// Return (left + right) mod modulus, where left and right are already
+// reduced modulo modulus.
+static UInt256 uint256_add_mod(UInt256 left, UInt256 right, const UInt256 *modulus) {
+  unsigned carry = 0;
+  for (unsigned x = 0; x < 4; x++) {
+    uint256_store_u64(&left, x, uint256_add64_carry(uint256_load_u64(&left, x), uint256_load_u64(&right, x), &carry));
+  }
+  // the true sum is 257 bits wide if there was a carry out
+  if (carry || uint256_inline_cmp(left, *modulus) >= 0) {
+    left = uint256_sub(left, *modulus);
+  }
+  return left;
+}
+
+// Set up ctx for Montgomery arithmetic modulo the given odd modulus.
+int uint256_mont_init(UInt256MontCtx *ctx, UInt256 modulus) {
+  if ((modulus.data[0] & 1) == 0) {
+    return UINT256_ERR_EVEN_MODULUS;
+  }
+  ctx->modulus = modulus;
+
+  // Newton's iteration for the inverse of the low word mod 2^64: n0 is its
+  // own inverse mod 2^3, and each step doubles the number of correct bits
+  uint64_t n0 = uint256_load_u64(&modulus, 0);
+  uint64_t inv = n0;
+  for (int i = 0; i < 5; i++) {
+    inv *= 2 - n0 * inv;
+  }
+  ctx->n0inv = (uint64_t) 0 - inv;
+
+  // R mod n, where R = 2^256, is (2^256 - n) mod n; doubling it another
+  // 256 times gives R^2 mod n
+  UInt256 r2 = uint256_mod(uint256_negate(modulus), modulus);
+  for (int i = 0; i < 256; i++) {
+    r2 = uint256_add_mod(r2, r2, &modulus);
+  }
+  ctx->r2 = r2;
+  return UINT256_OK;
+}
+
+// Montgomery multiplication: return left * right * 2^-256 mod n.
+UInt256 uint256_mont_mul(const UInt256MontCtx *ctx, UInt256 left, UInt256 right) {
+  uint64_t a[4], b[4], n[4], t[6] = {0, 0, 0, 0, 0, 0};
+  for (unsigned x = 0; x < 4; x++) {
+    a[x] = uint256_load_u64(&left, x);
+    b[x] = uint256_load_u64(&right, x);
+    n[x] = uint256_load_u64(&ctx->modulus, x);
+  }
+  // CIOS method: interleave one row of the product with one word of reduction
+  for (unsigned i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (unsigned j = 0; j < 4; j++) {
+      t[j] = uint256_mul64_add(a[j], b[i], t[j], carry, &carry);
+    }
+    unsigned c = 0;
+    t[4] = uint256_add64_carry(t[4], carry, &c);
+    t[5] = c;
+
+    // choose m so that adding m*n clears the lowest word, then drop that word
+    uint64_t m = t[0] * ctx->n0inv;
+    uint256_mul64_add(m, n[0], t[0], 0, &carry);
+    for (unsigned j = 1; j < 4; j++) {
+      t[j - 1] = uint256_mul64_add(m, n[j], t[j], carry, &carry);
+    }
+    c = 0;
+    t[3] = uint256_add64_carry(t[4], carry, &c);
+    t[4] = t[5] + c;
+  }
+
+  UInt256 result;
+  for (unsigned x = 0; x < 4; x++) {
+    uint256_store_u64(&result, x, t[x]);
+  }
+  // the result is below 2n, so at most one subtraction is needed
+  if (t[4] != 0 || uint256_inline_cmp(result, ctx->modulus) >= 0) {
+    result = uint256_sub(result, ctx->modulus);
+  }
+  return result;
+}
+
+// Convert val (any value) into Montgomery form, val * 2^256 mod n.
+UInt256 uint256_mont_to(const UInt256MontCtx *ctx, UInt256 val) {
+  return uint256_mont_mul(ctx, uint256_mod(val, ctx->modulus), ctx->r2);
+}
+
+// Convert val out of Montgomery form, val * 2^-256 mod n.
+UInt256 uint256_mont_from(const UInt256MontCtx *ctx, UInt256 val) {
+  return uint256_mont_mul(ctx, val, uint256_create_from_u32(1));
+}
+
+// Return base^exp mod n.
+UInt256 uint256_mont_pow(const UInt256MontCtx *ctx, UInt256 base, UInt256 exp) {
+  UInt256 b = uint256_mont_to(ctx, base);
+  // 1 in Montgomery form is R mod n
+  UInt256 result = uint256_mont_to(ctx, uint256_create_from_u32(1));
+  // left-to-right square and multiply over the bits of exp
+  for (int i = 255; i >= 0; i--) {
+    result = uint256_mont_mul(ctx, result, result);
+    if ((exp.data[i / 32] >> (i % 32)) & 1) {
+      result = uint256_mont_mul(ctx, result, b);
+    }
+  }
+  return uint256_mont_from(ctx, result);
 }
@@ -1,8 +1,13 @@
 #ifndef UINT256_H
 #define UINT256_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Data type representing a 256-bit unsigned integer, represented
 // as an array of 8 uint32_t values. It is expected that the value
 // at index 0 is the least significant, and the value at index 7
@@ -14,6 +19,14 @@ typedef struct {
   uint32_t data[8];
 } UInt256;
 
+// Data type representing a 512-bit unsigned integer, used for the
+// full (non-truncated) product of two UInt256 values. Just like
+// UInt256, the value at index 0 is the least significant and the
+// value at index 15 is the most significant.
+typedef struct {
+  uint32_t data[16];
+} UInt512;
+
 // Create a UInt256 value from a single uint32_t value.
 // Only the least-significant 32 bits are initialized directly,
 // all other bits are set to 0.
@@ -24,13 +37,56 @@ UInt256 uint256_create_from_u32(uint32_t val);
 // at index 7 is the most significant.
 UInt256 uint256_create(const uint32_t data[8]);
 
+// Status codes returned by the parsing functions.
+#define UINT256_OK 0
+#define UINT256_ERR_INVALID_DIGIT (-1)
+#define UINT256_ERR_DIV_BY_ZERO (-2)
+#define UINT256_ERR_EVEN_MODULUS (-3)
+#define UINT256_ERR_OVERFLOW (-4)
+
 // Create a UInt256 value from a string of hexadecimal digits.
+// Each group of 8 characters, counting from the right, is read like
+// strtoul(group, NULL, 16) would read it, so a group stops at the first
+// character that isn't a hex digit. Characters before the rightmost 64
+// are ignored. Use uint256_parse_hex_n to reject invalid strings.
 UInt256 uint256_create_from_hex(const char *hex);
 
+// Parse the len hexadecimal digits starting at hex (which doesn't need
+// to be NUL-terminated) into *result. If there are more than 64 digits,
+// only the least significant 256 bits are kept. Returns UINT256_OK on
+// success, or UINT256_ERR_INVALID_DIGIT (storing 0 in *result) if any
+// character isn't a hex digit. Doesn't allocate any memory.
+int uint256_parse_hex_n(const char *hex, size_t len, UInt256 *result);
+
 // Return a dynamically-allocated string of hex digits representing the
 // given UInt256 value.
 char *uint256_format_as_hex(UInt256 val);
 
+// Write the hex digits of val, without leading zeros, into the caller's
+// buffer out, followed by a NUL terminator. Returns the number of digits
+// written (1 to 64). Doesn't allocate any memory.
+size_t uint256_format_hex_into(UInt256 val, char out[65]);
+
+// Create a UInt256 value from a string of decimal digits.
+// If the string contains a character which isn't a decimal digit,
+// or the value doesn't fit in 256 bits, the result is 0.
+UInt256 uint256_create_from_dec(const char *dec);
+
+// Parse the len decimal digits starting at dec (which doesn't need to be
+// NUL-terminated) into *result. Returns UINT256_OK on success, or
+// UINT256_ERR_INVALID_DIGIT / UINT256_ERR_OVERFLOW (storing 0 in *result)
+// if a character isn't a decimal digit or the value is 2^256 or more.
+int uint256_parse_dec_n(const char *dec, size_t len, UInt256 *result);
+
+// Return a dynamically-allocated string of decimal digits representing
+// the given UInt256 value.
+char *uint256_format_as_dec(UInt256 val);
+
+// Write the decimal digits of val, without leading zeros, into the
+// caller's buffer out, followed by a NUL terminator. Returns the number
+// of digits written (1 to 78). Doesn't allocate any memory.
+size_t uint256_format_dec_into(UInt256 val, char out[79]);
+
 // Helper function for uint256_format_as_hex to trim zeros off final string
 void trimLeadingZeros(char *str);
 
@@ -50,12 +106,21 @@ UInt256 uint256_sub(UInt256 left, UInt256 right);
 
 // Return the two's-complement negation of the given UInt256 value.
 UInt256 uint256_negate(UInt256 val);
-#if 0
 
-// Not assigning this for Fall 2023
-// Compute the product of two UInt256 values.
+// Compute the product of two UInt256 values. Only the least
+// significant 256 bits of the product are kept.
 UInt256 uint256_mul(UInt256 left, UInt256 right);
-#endif
+
+// Compute the full 512-bit product of two UInt256 values.
+UInt512 uint256_mul_wide(UInt256 left, UInt256 right);
+
+// Return val shifted left by nbits. Bits shifted past the most
+// significant bit are lost; a shift of 256 or more gives 0.
+UInt256 uint256_shl(UInt256 val, unsigned nbits);
+
+// Return val shifted right by nbits. Bits shifted past the least
+// significant bit are lost; a shift of 256 or more gives 0.
+UInt256 uint256_shr(UInt256 val, unsigned nbits);
 
 // Return the result of rotating every bit in val nbits to
 // the left.  Any bits shifted past the most significant bit
@@ -67,6 +132,91 @@ UInt256 uint256_rotate_left(UInt256 val, unsigned nbits);
 // should be shifted back into the most significant bits.
 UInt256 uint256_rotate_right(UInt256 val, unsigned nbits);
 
+// Compare two UInt256 values, returning -1 if left < right, 0 if they
+// are equal and 1 if left > right. Runs in the same time regardless of
+// where the values differ.
+int uint256_cmp(UInt256 left, UInt256 right);
+
+// Return 1 if left and right are equal, 0 otherwise.
+int uint256_eq(UInt256 left, UInt256 right);
+
+// Bitwise AND, OR, XOR and complement of UInt256 values.
+UInt256 uint256_and(UInt256 left, UInt256 right);
+UInt256 uint256_or(UInt256 left, UInt256 right);
+UInt256 uint256_xor(UInt256 left, UInt256 right);
+UInt256 uint256_not(UInt256 val);
+
+// Return the number of leading (most significant) zero bits in val.
+// Returns 256 if val is 0.
+unsigned uint256_clz(UInt256 val);
+
+// Return the number of trailing (least significant) zero bits in val.
+// Returns 256 if val is 0.
+unsigned uint256_ctz(UInt256 val);
+
+// Return the number of bits in val that are 1.
+unsigned uint256_popcount(UInt256 val);
+
+// Divide num by den, storing the quotient in *quot and the remainder
+// in *rem (either pointer may be NULL if that result isn't needed).
+// Returns UINT256_OK, or UINT256_ERR_DIV_BY_ZERO (without storing
+// anything) if den is 0.
+int uint256_divmod(UInt256 num, UInt256 den, UInt256 *quot, UInt256 *rem);
+
+// Return num mod den. The result is 0 if den is 0.
+UInt256 uint256_mod(UInt256 num, UInt256 den);
+
+// Precomputed values for Montgomery arithmetic modulo an odd modulus n,
+// with R = 2^256. Values in Montgomery form are stored as x*R mod n.
+typedef struct {
+  UInt256 modulus; // the odd modulus n
+  UInt256 r2;      // R^2 mod n, used to convert into Montgomery form
+  uint64_t n0inv;  // -n^-1 mod 2^64
+} UInt256MontCtx;
+
+// Set up ctx for arithmetic modulo the given modulus. Returns UINT256_OK,
+// or UINT256_ERR_EVEN_MODULUS if modulus is even.
+int uint256_mont_init(UInt256MontCtx *ctx, UInt256 modulus);
+
+// Return left * right * R^-1 mod n. Both operands must be less than n.
+// If they are in Montgomery form, so is the result.
+UInt256 uint256_mont_mul(const UInt256MontCtx *ctx, UInt256 left, UInt256 right);
+
+// Convert val into Montgomery form (val * R mod n).
+UInt256 uint256_mont_to(const UInt256MontCtx *ctx, UInt256 val);
+
+// Convert val (which must be less than n) out of Montgomery form.
+UInt256 uint256_mont_from(const UInt256MontCtx *ctx, UInt256 val);
+
+// Return base^exp mod n. base and the result are ordinary values,
+// not in Montgomery form.
+UInt256 uint256_mont_pow(const UInt256MontCtx *ctx, UInt256 base, UInt256 exp);
+
+// Batch versions of the operations above, which process n values at
+// once instead of passing and returning each value individually.
+// They are implemented in uint256_batch.c, using AVX2 kernels when the
+// CPU supports them and a scalar loop otherwise. It is fine for out to
+// be the same array as one of the inputs.
+
+// Compute out[i] = a[i] + b[i] for i in 0..n-1.
+void uint256_add_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n);
+
+// Compute out[i] = a[i] - b[i] for i in 0..n-1.
+void uint256_sub_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n);
+
+// Compute out[i] = -a[i] for i in 0..n-1.
+void uint256_negate_n(const UInt256 *a, UInt256 *out, size_t n);
+
+// Rotate each of a[0..n-1] left by nbits, storing the results in out.
+void uint256_rotate_left_n(const UInt256 *a, unsigned nbits, UInt256 *out, size_t n);
+
+// Rotate each of a[0..n-1] right by nbits, storing the results in out.
+void uint256_rotate_right_n(const UInt256 *a, unsigned nbits, UInt256 *out, size_t n);
+
 // You may add additional functions if you would like to
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // UINT256_H
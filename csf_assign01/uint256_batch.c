@@ -0,0 +1,204 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "uint256.h"
+
+// The AVX2 kernels are compiled with a target attribute so the rest of the
+// program doesn't need -mavx2, and are only called after checking at runtime
+// that the CPU actually supports AVX2.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define UINT256_BATCH_HAVE_AVX2 1
+#define UINT256_AVX2 __attribute__((target("avx2")))
+// forced inlining lets the compiler drop the add/subtract switch in the kernels
+#define UINT256_AVX2_INLINE __attribute__((target("avx2"), always_inline))
+#endif
+
+#if defined(UINT256_BATCH_HAVE_AVX2)
+
+// return 1 if the running CPU supports AVX2 (checked once, then cached)
+static int uint256_cpu_has_avx2(void) {
+  static int has_avx2 = -1;
+  if (has_avx2 < 0) {
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return has_avx2;
+}
+
+// Transpose four UInt256 values (one per register, as four 64-bit words)
+// into structure-of-arrays form, where register k holds 64-bit word k of
+// all four values. The transpose is its own inverse, so the same function
+// also turns SoA results back into one value per register.
+UINT256_AVX2_INLINE static inline void uint256_transpose4(__m256i *v0, __m256i *v1, __m256i *v2, __m256i *v3) {
+  __m256i t0 = _mm256_unpacklo_epi64(*v0, *v1);
+  __m256i t1 = _mm256_unpackhi_epi64(*v0, *v1);
+  __m256i t2 = _mm256_unpacklo_epi64(*v2, *v3);
+  __m256i t3 = _mm256_unpackhi_epi64(*v2, *v3);
+  *v0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+  *v1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+  *v2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+  *v3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+// unsigned 64-bit left < right in every lane (all ones if true), since
+// AVX2 only has a signed 64-bit comparison
+UINT256_AVX2_INLINE static inline __m256i uint256_lt_epu64(__m256i left, __m256i right) {
+  const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+  return _mm256_cmpgt_epi64(_mm256_xor_si256(right, sign), _mm256_xor_si256(left, sign));
+}
+
+// Add (or subtract, if subtract is nonzero) four pairs of values at once.
+// Each lane of a register belongs to a different value, so the carry chain
+// runs over the four 64-bit words of four values in parallel.
+UINT256_AVX2_INLINE static inline void uint256_addsub4(const UInt256 *a, const UInt256 *b, UInt256 *out, int subtract) {
+  __m256i x[4], y[4];
+  for (int k = 0; k < 4; k++) {
+    x[k] = _mm256_loadu_si256((const __m256i *) &a[k]);
+    y[k] = _mm256_loadu_si256((const __m256i *) &b[k]);
+  }
+  uint256_transpose4(&x[0], &x[1], &x[2], &x[3]);
+  uint256_transpose4(&y[0], &y[1], &y[2], &y[3]);
+
+  // carry (or borrow) is kept as a mask: all ones means 1, zero means 0
+  __m256i carry = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi64x(-1);
+  for (int k = 0; k < 4; k++) {
+    __m256i partial, result, first, second;
+    if (subtract) {
+      partial = _mm256_sub_epi64(x[k], y[k]);
+      first = uint256_lt_epu64(x[k], y[k]);
+      // adding the all-ones mask subtracts the incoming borrow
+      result = _mm256_add_epi64(partial, carry);
+      second = _mm256_and_si256(carry, _mm256_cmpeq_epi64(partial, _mm256_setzero_si256()));
+    } else {
+      partial = _mm256_add_epi64(x[k], y[k]);
+      first = uint256_lt_epu64(partial, x[k]);
+      // subtracting the all-ones mask adds the incoming carry
+      result = _mm256_sub_epi64(partial, carry);
+      second = _mm256_and_si256(carry, _mm256_cmpeq_epi64(partial, ones));
+    }
+    x[k] = result;
+    carry = _mm256_or_si256(first, second);
+  }
+
+  uint256_transpose4(&x[0], &x[1], &x[2], &x[3]);
+  for (int k = 0; k < 4; k++) {
+    _mm256_storeu_si256((__m256i *) &out[k], x[k]);
+  }
+}
+
+UINT256_AVX2 static void uint256_add_n_avx2(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint256_addsub4(a + i, b + i, out + i, 0);
+  }
+  // leftover values are handled one at a time
+  for (; i < n; i++) {
+    out[i] = uint256_add(a[i], b[i]);
+  }
+}
+
+UINT256_AVX2 static void uint256_sub_n_avx2(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint256_addsub4(a + i, b + i, out + i, 1);
+  }
+  for (; i < n; i++) {
+    out[i] = uint256_sub(a[i], b[i]);
+  }
+}
+
+UINT256_AVX2 static void uint256_negate_n_avx2(const UInt256 *a, UInt256 *out, size_t n) {
+  const UInt256 zeros[4] = { { { 0 } } };
+  size_t i = 0;
+  // -a is 0 - a, so negation reuses the subtraction kernel
+  for (; i + 4 <= n; i += 4) {
+    uint256_addsub4(zeros, a + i, out + i, 1);
+  }
+  for (; i < n; i++) {
+    out[i] = uint256_negate(a[i]);
+  }
+}
+
+// Rotating left by nbits makes output limb i out of source limbs
+// i - nbits/32 and i - nbits/32 - 1, so one value fits in one register:
+// two cross-lane permutes pick the source limbs and two shifts combine them.
+UINT256_AVX2 static void uint256_rotate_left_n_avx2(const UInt256 *a, unsigned nbits, UInt256 *out, size_t n) {
+  nbits %= 256;
+  int limbs = nbits / 32;
+  int bits = nbits % 32;
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i seven = _mm256_set1_epi32(7);
+  __m256i idx_lo = _mm256_and_si256(_mm256_sub_epi32(lane, _mm256_set1_epi32(limbs)), seven);
+  __m256i idx_hi = _mm256_and_si256(_mm256_sub_epi32(lane, _mm256_set1_epi32(limbs + 1)), seven);
+  // shifting a 32-bit lane by 32 gives zero, which handles bits == 0
+  __m128i left_count = _mm_cvtsi32_si128(bits);
+  __m128i right_count = _mm_cvtsi32_si128(32 - bits);
+  for (size_t i = 0; i < n; i++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) &a[i]);
+    __m256i lo = _mm256_permutevar8x32_epi32(v, idx_lo);
+    __m256i hi = _mm256_permutevar8x32_epi32(v, idx_hi);
+    __m256i r = _mm256_or_si256(_mm256_sll_epi32(lo, left_count), _mm256_srl_epi32(hi, right_count));
+    _mm256_storeu_si256((__m256i *) &out[i], r);
+  }
+}
+
+#endif // UINT256_BATCH_HAVE_AVX2
+
+// Compute out[i] = a[i] + b[i] for i in 0..n-1.
+void uint256_add_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+#if defined(UINT256_BATCH_HAVE_AVX2)
+  if (uint256_cpu_has_avx2()) {
+    uint256_add_n_avx2(a, b, out, n);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    out[i] = uint256_add(a[i], b[i]);
+  }
+}
+
+// Compute out[i] = a[i] - b[i] for i in 0..n-1.
+void uint256_sub_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+#if defined(UINT256_BATCH_HAVE_AVX2)
+  if (uint256_cpu_has_avx2()) {
+    uint256_sub_n_avx2(a, b, out, n);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    out[i] = uint256_sub(a[i], b[i]);
+  }
+}
+
+// Compute out[i] = -a[i] for i in 0..n-1.
+void uint256_negate_n(const UInt256 *a, UInt256 *out, size_t n) {
+#if defined(UINT256_BATCH_HAVE_AVX2)
+  if (uint256_cpu_has_avx2()) {
+    uint256_negate_n_avx2(a, out, n);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    out[i] = uint256_negate(a[i]);
+  }
+}
+
+// Rotate each of a[0..n-1] left by nbits, storing the results in out.
+void uint256_rotate_left_n(const UInt256 *a, unsigned nbits, UInt256 *out, size_t n) {
+#if defined(UINT256_BATCH_HAVE_AVX2)
+  if (uint256_cpu_has_avx2()) {
+    uint256_rotate_left_n_avx2(a, nbits, out, n);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    out[i] = uint256_rotate_left(a[i], nbits);
+  }
+}
+
+// Rotate each of a[0..n-1] right by nbits, storing the results in out.
+void uint256_rotate_right_n(const UInt256 *a, unsigned nbits, UInt256 *out, size_t n) {
+  // rotating right by nbits is rotating left by 256 - nbits
+  uint256_rotate_left_n(a, 256 - (nbits % 256), out, n);
+}
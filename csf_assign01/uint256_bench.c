@@ -0,0 +1,614 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "uint256.h"
+#include "uint256_inline.h"
+
+// Number of values in the operand pools and number of timed operations
+#define POOL_SIZE 1024
+#define DEFAULT_ITERS 20000000UL
+
+// Reference implementations (the original limb-by-limb versions) that
+// the optimized functions in uint256.c are measured against.
+static UInt256 ref_add(UInt256 left, UInt256 right);
+static UInt256 ref_negate(UInt256 val);
+static UInt256 ref_sub(UInt256 left, UInt256 right);
+static UInt512 ref_mul_wide(UInt256 left, UInt256 right);
+static UInt256 ref_mul(UInt256 left, UInt256 right);
+static UInt256 ref_create_from_hex(const char *hex);
+static UInt256 ref_rotate_left(UInt256 val, unsigned nbits);
+static size_t ref_format_dec(UInt256 val, char out[79]);
+static UInt256 ref_rotate_right(UInt256 val, unsigned nbits);
+static char *ref_format_as_hex(UInt256 val);
+
+// Helper functions for running the benchmarks
+static uint32_t next_rand(uint64_t *state);
+static double now_ns(void);
+static int same(UInt256 a, UInt256 b);
+
+// Benchmarked operations, taking operands from the two pools
+typedef UInt256 (*BinaryOp)(UInt256, UInt256);
+typedef UInt512 (*WideOp)(UInt256, UInt256);
+typedef UInt256 (*ShiftOp)(UInt256, unsigned);
+
+static UInt256 left_pool[POOL_SIZE];
+static UInt256 right_pool[POOL_SIZE];
+
+// Keeps the compiler from optimizing away benchmarked calls
+static volatile uint32_t sink;
+
+static double time_binary_op(BinaryOp op, unsigned long iters) {
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (unsigned long i = 0; i < iters; i++) {
+    UInt256 result = op(left_pool[i % POOL_SIZE], right_pool[(i * 7) % POOL_SIZE]);
+    acc ^= result.data[i & 7];
+  }
+  double elapsed = now_ns() - start;
+  sink = acc;
+  return elapsed / iters;
+}
+
+static double time_wide_op(WideOp op, unsigned long iters) {
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (unsigned long i = 0; i < iters; i++) {
+    UInt512 result = op(left_pool[i % POOL_SIZE], right_pool[(i * 7) % POOL_SIZE]);
+    acc ^= result.data[i & 15];
+  }
+  double elapsed = now_ns() - start;
+  sink = acc;
+  return elapsed / iters;
+}
+
+static UInt256 negate_left(UInt256 left, UInt256 right) {
+  (void) right;
+  return uint256_negate(left);
+}
+
+static UInt256 ref_negate_left(UInt256 left, UInt256 right) {
+  (void) right;
+  return ref_negate(left);
+}
+
+static void report(const char *name, BinaryOp op, BinaryOp ref, unsigned long iters) {
+  // make sure both versions agree before timing them
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    if (!same(op(left_pool[i], right_pool[i]), ref(left_pool[i], right_pool[i]))) {
+      fprintf(stderr, "%s: result mismatch at index %u\n", name, i);
+      exit(1);
+    }
+  }
+  double ref_ns = time_binary_op(ref, iters);
+  double new_ns = time_binary_op(op, iters);
+  printf("%-8s reference: %7.2f ns/op   current: %7.2f ns/op   speedup: %5.2fx\n",
+         name, ref_ns, new_ns, ref_ns / new_ns);
+}
+
+static void report_wide(const char *name, WideOp op, WideOp ref, unsigned long iters) {
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    UInt512 a = op(left_pool[i], right_pool[i]);
+    UInt512 b = ref(left_pool[i], right_pool[i]);
+    for (unsigned k = 0; k < 16; k++) {
+      if (a.data[k] != b.data[k]) {
+        fprintf(stderr, "%s: result mismatch at index %u\n", name, i);
+        exit(1);
+      }
+    }
+  }
+  double ref_ns = time_wide_op(ref, iters);
+  double new_ns = time_wide_op(op, iters);
+  printf("%-8s reference: %7.2f ns/op   current: %7.2f ns/op   speedup: %5.2fx\n",
+         name, ref_ns, new_ns, ref_ns / new_ns);
+}
+
+// Time a shift/rotate for every shift count 0..511, reporting the fastest,
+// slowest and average count, so any dependence on nbits shows up as spread
+static void report_shift(const char *name, ShiftOp op, unsigned long iters) {
+  unsigned long per_count = iters / 512 + 1;
+  double min_ns = 1e300, max_ns = 0, total_ns = 0;
+  unsigned min_count = 0, max_count = 0;
+  uint32_t acc = 0;
+  for (unsigned nbits = 0; nbits < 512; nbits++) {
+    // best of three runs, to filter out scheduling noise
+    double ns = 1e300;
+    for (int run = 0; run < 3; run++) {
+      double start = now_ns();
+      for (unsigned long i = 0; i < per_count; i++) {
+        acc ^= op(left_pool[i % POOL_SIZE], nbits).data[i & 7];
+      }
+      double run_ns = (now_ns() - start) / per_count;
+      if (run_ns < ns) {
+        ns = run_ns;
+      }
+    }
+    total_ns += ns;
+    if (ns < min_ns) {
+      min_ns = ns;
+      min_count = nbits;
+    }
+    if (ns > max_ns) {
+      max_ns = ns;
+      max_count = nbits;
+    }
+  }
+  sink = acc;
+  printf("%-8s min: %7.2f ns/op (n=%3u)   max: %7.2f ns/op (n=%3u)   mean: %7.2f ns/op\n",
+         name, min_ns, min_count, max_ns, max_count, total_ns / 512);
+}
+
+// Compare chunked decimal conversion against one division by 10 per digit
+static void report_dec(unsigned long iters) {
+  unsigned long count = iters / 20 + 1;
+  static char strings[POOL_SIZE][79];
+  static size_t lengths[POOL_SIZE];
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    lengths[i] = uint256_format_dec_into(left_pool[i], strings[i]);
+  }
+  double start, ref_ns, new_ns;
+  uint32_t acc = 0;
+
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    char dec[79];
+    ref_format_dec(left_pool[i % POOL_SIZE], dec);
+    acc ^= (uint32_t) dec[i & 63];
+  }
+  ref_ns = (now_ns() - start) / count;
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    char dec[79];
+    uint256_format_dec_into(left_pool[i % POOL_SIZE], dec);
+    acc ^= (uint32_t) dec[i & 63];
+  }
+  new_ns = (now_ns() - start) / count;
+  printf("%-8s reference: %7.2f ns/op   current: %7.2f ns/op   speedup: %5.2fx\n",
+         "fmtdec", ref_ns, new_ns, ref_ns / new_ns);
+
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    UInt256 val;
+    uint256_parse_dec_n(strings[i % POOL_SIZE], lengths[i % POOL_SIZE], &val);
+    acc ^= val.data[i & 7];
+  }
+  printf("%-8s %7.2f ns/op\n", "parsedec", (now_ns() - start) / count);
+  sink = acc;
+}
+
+// Report division speed and Montgomery modular exponentiations per second
+// for a full-size modulus and exponent
+static void report_modular(unsigned long iters) {
+  uint32_t acc = 0;
+  double start;
+
+  start = now_ns();
+  for (unsigned long i = 0; i < iters; i++) {
+    UInt256 q, r;
+    UInt256 den = right_pool[(i * 7) % POOL_SIZE];
+    // vary the divisor size so both short and long division are timed
+    den.data[7 - (i % 8)] = 0;
+    uint256_divmod(left_pool[i % POOL_SIZE], den, &q, &r);
+    acc ^= q.data[i & 7] ^ r.data[i & 7];
+  }
+  printf("%-8s %7.2f ns/op\n", "divmod", (now_ns() - start) / iters);
+
+  // 2^255 - 19
+  UInt256 modulus = uint256_sub(uint256_shl(uint256_create_from_u32(1), 255), uint256_create_from_u32(19));
+  UInt256MontCtx ctx;
+  uint256_mont_init(&ctx, modulus);
+
+  UInt256 x = uint256_mont_to(&ctx, left_pool[0]);
+  start = now_ns();
+  for (unsigned long i = 0; i < iters; i++) {
+    x = uint256_mont_mul(&ctx, x, x);
+  }
+  acc ^= x.data[0];
+  printf("%-8s %7.2f ns/op\n", "mont_mul", (now_ns() - start) / iters);
+
+  // each exponentiation is ~384 Montgomery multiplies, so do far fewer
+  unsigned long pows = iters / 2000 + 1;
+  start = now_ns();
+  for (unsigned long i = 0; i < pows; i++) {
+    acc ^= uint256_mont_pow(&ctx, left_pool[i % POOL_SIZE], right_pool[i % POOL_SIZE]).data[0];
+  }
+  double elapsed = now_ns() - start;
+  printf("%-8s %7.2f us/op   %9.0f exps/s\n", "mont_pow", elapsed / pows / 1000, pows / (elapsed / 1e9));
+  sink = acc;
+}
+
+// Compare hex parsing and formatting against the original malloc/strtoul/
+// sprintf based versions
+static void report_hex(unsigned long iters) {
+  // hex strings are much slower than arithmetic, so do fewer of them
+  unsigned long count = iters / 10 + 1;
+  static char strings[POOL_SIZE][65];
+  static size_t lengths[POOL_SIZE];
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    lengths[i] = uint256_format_hex_into(left_pool[i], strings[i]);
+  }
+  // make sure every string parses, to the same value as the reference
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    UInt256 val;
+    if (uint256_parse_hex_n(strings[i], lengths[i], &val) != UINT256_OK ||
+        !same(val, ref_create_from_hex(strings[i]))) {
+      fprintf(stderr, "parsehex: result mismatch at index %u\n", i);
+      exit(1);
+    }
+  }
+  double start, ref_ns, new_ns;
+  uint32_t acc = 0;
+
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    acc ^= ref_create_from_hex(strings[i % POOL_SIZE]).data[i & 7];
+  }
+  ref_ns = (now_ns() - start) / count;
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    UInt256 val;
+    uint256_parse_hex_n(strings[i % POOL_SIZE], lengths[i % POOL_SIZE], &val);
+    acc ^= val.data[i & 7];
+  }
+  new_ns = (now_ns() - start) / count;
+  printf("%-8s reference: %7.2f ns/op   current: %7.2f ns/op   speedup: %5.2fx\n",
+         "parsehex", ref_ns, new_ns, ref_ns / new_ns);
+
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    char *hex = ref_format_as_hex(left_pool[i % POOL_SIZE]);
+    acc ^= (uint32_t) hex[i & 31];
+    free(hex);
+  }
+  ref_ns = (now_ns() - start) / count;
+  start = now_ns();
+  for (unsigned long i = 0; i < count; i++) {
+    char hex[65];
+    uint256_format_hex_into(left_pool[i % POOL_SIZE], hex);
+    acc ^= (uint32_t) hex[i & 31];
+  }
+  new_ns = (now_ns() - start) / count;
+  printf("%-8s reference: %7.2f ns/op   current: %7.2f ns/op   speedup: %5.2fx\n",
+         "fmthex", ref_ns, new_ns, ref_ns / new_ns);
+  sink = acc;
+}
+
+// Compare calling the single-value functions in a loop against the batch API
+static void report_batch(unsigned long iters) {
+  static UInt256 out[POOL_SIZE];
+  unsigned long rounds = iters / POOL_SIZE;
+  if (rounds == 0) {
+    rounds = 1;
+  }
+  double total = (double) rounds * POOL_SIZE;
+  double start, loop_ns, batch_ns;
+  uint32_t acc = 0;
+
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    for (unsigned i = 0; i < POOL_SIZE; i++) {
+      out[i] = uint256_add(left_pool[i], right_pool[i]);
+    }
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  loop_ns = (now_ns() - start) / total;
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    uint256_add_n(left_pool, right_pool, out, POOL_SIZE);
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  batch_ns = (now_ns() - start) / total;
+  printf("%-8s loop:      %7.2f ns/op   batch:   %7.2f ns/op   speedup: %5.2fx\n",
+         "add_n", loop_ns, batch_ns, loop_ns / batch_ns);
+
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    for (unsigned i = 0; i < POOL_SIZE; i++) {
+      out[i] = uint256_sub(left_pool[i], right_pool[i]);
+    }
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  loop_ns = (now_ns() - start) / total;
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    uint256_sub_n(left_pool, right_pool, out, POOL_SIZE);
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  batch_ns = (now_ns() - start) / total;
+  printf("%-8s loop:      %7.2f ns/op   batch:   %7.2f ns/op   speedup: %5.2fx\n",
+         "sub_n", loop_ns, batch_ns, loop_ns / batch_ns);
+
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    for (unsigned i = 0; i < POOL_SIZE; i++) {
+      out[i] = uint256_negate(left_pool[i]);
+    }
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  loop_ns = (now_ns() - start) / total;
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    uint256_negate_n(left_pool, out, POOL_SIZE);
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  batch_ns = (now_ns() - start) / total;
+  printf("%-8s loop:      %7.2f ns/op   batch:   %7.2f ns/op   speedup: %5.2fx\n",
+         "negate_n", loop_ns, batch_ns, loop_ns / batch_ns);
+
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    for (unsigned i = 0; i < POOL_SIZE; i++) {
+      out[i] = uint256_rotate_left(left_pool[i], (unsigned) r);
+    }
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  loop_ns = (now_ns() - start) / total;
+  start = now_ns();
+  for (unsigned long r = 0; r < rounds; r++) {
+    uint256_rotate_left_n(left_pool, (unsigned) r, out, POOL_SIZE);
+    acc ^= out[r % POOL_SIZE].data[0];
+  }
+  batch_ns = (now_ns() - start) / total;
+  printf("%-8s loop:      %7.2f ns/op   batch:   %7.2f ns/op   speedup: %5.2fx\n",
+         "rotl_n", loop_ns, batch_ns, loop_ns / batch_ns);
+  sink = acc;
+}
+
+// Time body (which uses the loop counter i and updates acc) over iters
+// iterations, storing the time per iteration in ns.
+#define TIME_LOOP(ns, iters, body) do { \
+    double start_ = now_ns(); \
+    for (unsigned long i = 0; i < (iters); i++) { \
+      body; \
+    } \
+    (ns) = (now_ns() - start_) / (iters); \
+  } while (0)
+
+// Compare calling the out-of-line functions in uint256.c against the
+// static inline versions from uint256_inline.h. Each loop feeds its result
+// into the next operation, so the inlined versions can keep acc in registers.
+static void report_inline(unsigned long iters) {
+  struct {
+    const char *name;
+    double call_ns, inline_ns;
+  } rows[4] = { { "add", 0, 0 }, { "sub", 0, 0 }, { "rotl", 0, 0 }, { "cmp", 0, 0 } };
+  UInt256 acc = uint256_create_from_u32(1), acc_inline = acc;
+  int order = 0, order_inline = 0;
+
+  TIME_LOOP(rows[0].call_ns, iters, acc = uint256_add(acc, left_pool[i % POOL_SIZE]));
+  TIME_LOOP(rows[0].inline_ns, iters, acc_inline = uint256_inline_add(acc_inline, left_pool[i % POOL_SIZE]));
+  TIME_LOOP(rows[1].call_ns, iters, acc = uint256_sub(acc, right_pool[i % POOL_SIZE]));
+  TIME_LOOP(rows[1].inline_ns, iters, acc_inline = uint256_inline_sub(acc_inline, right_pool[i % POOL_SIZE]));
+  TIME_LOOP(rows[2].call_ns, iters, acc = uint256_rotate_left(acc, (unsigned) i));
+  TIME_LOOP(rows[2].inline_ns, iters, acc_inline = uint256_inline_rotate_left(acc_inline, (unsigned) i));
+  // the previous result picks the next operand, so comparisons can't overlap
+  TIME_LOOP(rows[3].call_ns, iters,
+            order += uint256_cmp(left_pool[i % POOL_SIZE], right_pool[(i + order) % POOL_SIZE]) + 1);
+  TIME_LOOP(rows[3].inline_ns, iters,
+            order_inline += uint256_inline_cmp(left_pool[i % POOL_SIZE], right_pool[(i + order_inline) % POOL_SIZE]) + 1);
+
+  if (!same(acc, acc_inline) || order != order_inline) {
+    fprintf(stderr, "inline: result mismatch\n");
+    exit(1);
+  }
+  for (int r = 0; r < 4; r++) {
+    printf("%-8s call:      %7.2f ns/op   inline:  %7.2f ns/op   speedup: %5.2fx\n",
+           rows[r].name, rows[r].call_ns, rows[r].inline_ns, rows[r].call_ns / rows[r].inline_ns);
+  }
+  sink = acc.data[0] ^ (uint32_t) order;
+}
+
+int main(int argc, char **argv) {
+  unsigned long iters = DEFAULT_ITERS;
+  if (argc > 1) {
+    iters = strtoul(argv[1], NULL, 10);
+    if (iters == 0) {
+      fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // fill the operand pools, including some values that carry/borrow all the way through
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  for (unsigned i = 0; i < POOL_SIZE; i++) {
+    for (unsigned k = 0; k < 8; k++) {
+      left_pool[i].data[k] = next_rand(&state);
+      right_pool[i].data[k] = (i % 16 == 0) ? 0xFFFFFFFFU : next_rand(&state);
+    }
+  }
+
+  report("add", uint256_add, ref_add, iters);
+  report("sub", uint256_sub, ref_sub, iters);
+  report("negate", negate_left, ref_negate_left, iters);
+  report("mul", uint256_mul, ref_mul, iters);
+  report_wide("mul_wide", uint256_mul_wide, ref_mul_wide, iters);
+  report_batch(iters);
+  report_hex(iters);
+  report_dec(iters);
+  report_modular(iters / 10 + 1);
+  report_shift("rotl_ref", ref_rotate_left, iters);
+  report_shift("rotl", uint256_rotate_left, iters);
+  report_shift("rotr_ref", ref_rotate_right, iters);
+  report_shift("rotr", uint256_rotate_right, iters);
+  report_shift("shl", uint256_shl, iters);
+  report_shift("shr", uint256_shr, iters);
+  report_inline(iters);
+  return 0;
+}
+
+static UInt256 ref_add(UInt256 left, UInt256 right) {
+  UInt256 sum;
+  uint32_t carry = 0;
+  for (int x = 0; x < 8; x++) {
+    uint32_t left_val = left.data[x];
+    uint32_t cur_sum = left_val + right.data[x] + carry;
+    sum.data[x] = cur_sum;
+    if (cur_sum < left_val) {
+      carry = 1;
+    }
+    else if (cur_sum == left_val) {
+      continue;
+    }
+    else {
+      carry = 0;
+    }
+  }
+  return sum;
+}
+
+static UInt256 ref_negate(UInt256 val) {
+  UInt256 result;
+  for (int k = 0; k < 8; k++) {
+    result.data[k] = ~val.data[k];
+  }
+  return ref_add(result, uint256_create_from_u32(1));
+}
+
+static UInt256 ref_sub(UInt256 left, UInt256 right) {
+  return ref_add(left, ref_negate(right));
+}
+
+// schoolbook multiplication on 32-bit limbs with 64-bit partial products
+static UInt512 ref_mul_wide(UInt256 left, UInt256 right) {
+  UInt512 prod;
+  for (int i = 0; i < 16; i++) {
+    prod.data[i] = 0;
+  }
+  for (int i = 0; i < 8; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < 8; j++) {
+      uint64_t t = (uint64_t) left.data[i] * right.data[j] + prod.data[i + j] + carry;
+      prod.data[i + j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+    prod.data[i + 8] = (uint32_t) carry;
+  }
+  return prod;
+}
+
+static UInt256 ref_mul(UInt256 left, UInt256 right) {
+  UInt256 prod;
+  for (int i = 0; i < 8; i++) {
+    prod.data[i] = 0;
+  }
+  for (int i = 0; i < 8; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; i + j < 8; j++) {
+      uint64_t t = (uint64_t) left.data[i] * right.data[j] + prod.data[i + j] + carry;
+      prod.data[i + j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+  }
+  return prod;
+}
+
+static UInt256 ref_create_from_hex(const char *hex) {
+  UInt256 result;
+  int len = strlen(hex);
+  int index = 0;
+  while (index != 8 && len >= 0) {
+    int digits_to_read = len >= 8 ? 8 : len;
+    const char* chunk = hex + (len - digits_to_read);
+    char* read = malloc(9*sizeof(char));
+    strncpy(read, chunk, digits_to_read);
+    read[digits_to_read] = '\0';
+    result.data[index] = strtoul(read, NULL, 16);
+    free(read);
+    index++;
+    len -= 8;
+  }
+  while (index != 8) {
+    result.data[index] = 0;
+    index++;
+  }
+  return result;
+}
+
+static char *ref_format_as_hex(UInt256 val) {
+  char *hex = malloc(65*sizeof(char));
+  char *hex_temp = hex;
+  hex[0] = '\0';
+  for (int i = 7; i >= 0; i--) {
+    char buf[9];
+    sprintf(buf, "%08x", val.data[i]);
+    strcpy(hex_temp, buf);
+    hex_temp += strlen(buf);
+  }
+  trimLeadingZeros(hex);
+  // keep a single digit for zero
+  if (hex[0] == '\0') {
+    hex[0] = '0';
+    hex[1] = '\0';
+  }
+  return hex;
+}
+
+static UInt256 ref_rotate_left(UInt256 val, unsigned nbits) {
+  UInt256 result = val;
+  nbits = nbits % 256;
+  int ints_to_shift = nbits / 32;
+  for (int i = 0; i < ints_to_shift; i++) {
+    uint32_t left_block = result.data[7];
+    for (int k = 7; k > 0; k--) {
+      result.data[k] = result.data[k - 1];
+    }
+    result.data[0] = left_block;
+  }
+  uint32_t leftover_bits = nbits % 32;
+  if (leftover_bits > 0) {
+    uint32_t spill_over = 0;
+    for (int x = 0; x < 8; x++) {
+      uint32_t temp = result.data[x];
+      result.data[x] = (result.data[x] << leftover_bits) | spill_over;
+      spill_over = temp >> (32-leftover_bits);
+    }
+    result.data[0] = result.data[0] | spill_over;
+  }
+  return result;
+}
+
+static UInt256 ref_rotate_right(UInt256 val, unsigned nbits) {
+  nbits = nbits % 256;
+  return ref_rotate_left(val, 256-nbits);
+}
+
+// one digit at a time, dividing the whole value by 10 for each digit
+static size_t ref_format_dec(UInt256 val, char out[79]) {
+  char digits[78];
+  size_t n = 0;
+  UInt256 ten = uint256_create_from_u32(10);
+  do {
+    UInt256 rem;
+    uint256_divmod(val, ten, &val, &rem);
+    digits[n++] = (char) ('0' + rem.data[0]);
+  } while (!isZero(val));
+  for (size_t i = 0; i < n; i++) {
+    out[i] = digits[n - 1 - i];
+  }
+  out[n] = '\0';
+  return n;
+}
+
+// xorshift64* generator, good enough for benchmark operands
+static uint32_t next_rand(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (uint32_t) ((*state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int same(UInt256 a, UInt256 b) {
+  for (unsigned i = 0; i < 8; i++) {
+    if (a.data[i] != b.data[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "tctest.h"
+#include "uint256.h"
+#include "uint256_inline.h"
+
+// Tests for the constexpr UInt256Value wrapper. The static_asserts check
+// that the operators really are evaluated at compile time; the runtime
+// tests check that they agree with the C functions in uint256.c.
+
+typedef struct {
+  UInt256 values[4];
+} TestObjs;
+
+TestObjs *setup(void);
+void cleanup(TestObjs *objs);
+
+void test_constexpr_ops(TestObjs *objs);
+void test_matches_c_functions(TestObjs *objs);
+
+static constexpr UInt256Value max_value = UInt256Value() - UInt256Value(1U);
+static constexpr UInt256Value high_bit = UInt256Value(1U) << 255;
+
+static_assert(max_value + UInt256Value(1U) == UInt256Value(), "max + 1 wraps to 0");
+static_assert(-UInt256Value(1U) == max_value, "negation of 1 is all ones");
+static_assert(max_value.get_bits(7) == 0xFFFFFFFFU, "borrow propagates to the top word");
+static_assert(high_bit.get_bits(7) == 0x80000000U && high_bit.get_bits(0) == 0U, "shl by 255");
+static_assert((high_bit >> 255) == UInt256Value(1U), "shr by 255");
+static_assert((high_bit << 1) == UInt256Value(), "bits shifted out are lost");
+static_assert(high_bit.rotate_left(1) == UInt256Value(1U), "rotate wraps around");
+static_assert(UInt256Value(1U).rotate_right(1) == high_bit, "rotate right wraps around");
+static_assert((~high_bit & high_bit) == UInt256Value() && (~high_bit | high_bit) == max_value, "bitwise operators");
+static_assert(UInt256Value(2U) < high_bit && high_bit > UInt256Value(2U), "ordering");
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    tctest_testname_to_execute = argv[1];
+  }
+
+  TEST_INIT();
+
+  TEST(test_constexpr_ops);
+  TEST(test_matches_c_functions);
+
+  TEST_FINI();
+}
+
+TestObjs *setup(void) {
+  TestObjs *objs = (TestObjs *) malloc(sizeof(TestObjs));
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  for (int i = 0; i < 4; i++) {
+    for (int k = 0; k < 8; k++) {
+      // xorshift64*
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      objs->values[i].data[k] = (uint32_t) ((state * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+  }
+  return objs;
+}
+
+void cleanup(TestObjs *objs) {
+  free(objs);
+}
+
+void test_constexpr_ops(TestObjs *objs) {
+  (void) objs;
+
+  constexpr uint32_t words[8] = { 0xFFFFFFFFU, 0xFFFFFFFFU, 0, 0, 0, 0, 0, 0x12345678U };
+  constexpr UInt256Value val = UInt256Value::from_words(words);
+  constexpr UInt256Value sum = val + UInt256Value(1U);
+  ASSERT(sum.get_bits(0) == 0U);
+  ASSERT(sum.get_bits(1) == 0U);
+  ASSERT(sum.get_bits(2) == 1U);
+  ASSERT(sum.get_bits(7) == 0x12345678U);
+  ASSERT(sum - UInt256Value(1U) == val);
+  ASSERT((val >> 32).get_bits(0) == 0xFFFFFFFFU);
+  ASSERT((val >> 32).get_bits(6) == 0x12345678U);
+  ASSERT(val.rotate_left(256) == val);
+  ASSERT(val.rotate_left(100).rotate_right(100) == val);
+}
+
+void test_matches_c_functions(TestObjs *objs) {
+  for (int i = 0; i < 4; i++) {
+    UInt256 a = objs->values[i], b = objs->values[(i + 1) % 4];
+    UInt256Value va(a), vb(b);
+    ASSERT((va + vb) == UInt256Value(uint256_add(a, b)));
+    ASSERT((va - vb) == UInt256Value(uint256_sub(a, b)));
+    ASSERT(-va == UInt256Value(uint256_negate(a)));
+    ASSERT(va.compare(vb) == uint256_cmp(a, b));
+    ASSERT((va & vb) == UInt256Value(uint256_and(a, b)));
+    ASSERT((va | vb) == UInt256Value(uint256_or(a, b)));
+    ASSERT((va ^ vb) == UInt256Value(uint256_xor(a, b)));
+    ASSERT(~va == UInt256Value(uint256_not(a)));
+    for (unsigned nbits = 0; nbits < 300; nbits += 7) {
+      ASSERT((va << nbits) == UInt256Value(uint256_shl(a, nbits)));
+      ASSERT((va >> nbits) == UInt256Value(uint256_shr(a, nbits)));
+      ASSERT(va.rotate_left(nbits) == UInt256Value(uint256_rotate_left(a, nbits)));
+      ASSERT(va.rotate_right(nbits) == UInt256Value(uint256_rotate_right(a, nbits)));
+    }
+  }
+}
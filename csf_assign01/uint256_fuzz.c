@@ -0,0 +1,841 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "uint256.h"
+
+// Differential fuzzer: checks every uint256 operation against an
+// independent reference built on pairs of unsigned __int128 values, over
+// millions of random operands, and reports the throughput of each
+// operation measured on the same operands.
+//
+// Usage: uint256_fuzz [pairs] [seed]
+
+#if !defined(__SIZEOF_INT128__)
+#error "uint256_fuzz needs a compiler with unsigned __int128"
+#endif
+
+__extension__ typedef unsigned __int128 u128;
+
+// Operands are generated and checked in pools of this many pairs
+#define POOL_SIZE 65536
+#define DEFAULT_PAIRS 2000000UL
+// Show at most this many mismatches per operation
+#define MAX_REPORTED 5
+// The slow reference for Montgomery multiplication only checks every
+// MONT_STRIDE-th pair
+#define MONT_STRIDE 64
+
+// Reference value: a 256-bit integer as two 128-bit halves
+typedef struct {
+  u128 lo, hi;
+} Ref256;
+
+// Result counters for one operation
+typedef struct {
+  const char *name;
+  unsigned long checked;
+  unsigned long mismatches;
+  double ns;        // total time spent in timed calls
+  unsigned long ops; // number of timed calls
+} OpStats;
+
+typedef UInt256 (*BinaryOp)(UInt256, UInt256);
+typedef UInt256 (*UnaryOp)(UInt256);
+typedef UInt256 (*ShiftOp)(UInt256, unsigned);
+typedef unsigned (*CountOp)(UInt256);
+typedef int (*CompareOp)(UInt256, UInt256);
+typedef void (*BatchOp)(const UInt256 *, const UInt256 *, UInt256 *, size_t);
+
+// Reference implementations
+static Ref256 to_ref(UInt256 val);
+static UInt256 from_ref(Ref256 ref);
+static UInt256 ref_add(UInt256 left, UInt256 right);
+static UInt256 ref_sub(UInt256 left, UInt256 right);
+static UInt256 ref_mul(UInt256 left, UInt256 right);
+static UInt512 ref_mul_wide(UInt256 left, UInt256 right);
+static UInt256 ref_and(UInt256 left, UInt256 right);
+static UInt256 ref_or(UInt256 left, UInt256 right);
+static UInt256 ref_xor(UInt256 left, UInt256 right);
+static UInt256 ref_negate(UInt256 val);
+static UInt256 ref_not(UInt256 val);
+static UInt256 ref_shl(UInt256 val, unsigned nbits);
+static UInt256 ref_shr(UInt256 val, unsigned nbits);
+static UInt256 ref_rotate_left(UInt256 val, unsigned nbits);
+static UInt256 ref_rotate_right(UInt256 val, unsigned nbits);
+static int ref_cmp(UInt256 left, UInt256 right);
+static int ref_eq(UInt256 left, UInt256 right);
+static unsigned ref_clz(UInt256 val);
+static unsigned ref_ctz(UInt256 val);
+static unsigned ref_popcount(UInt256 val);
+static UInt256 ref_mod(UInt256 num, UInt256 den);
+static UInt256 ref_mulmod(UInt256 left, UInt256 right, UInt256 modulus);
+static void ref_format_hex(UInt256 val, char out[65]);
+static void ref_format_dec(UInt256 val, char out[79]);
+
+// Helpers
+static uint32_t next_rand(uint64_t *state);
+static void random_operand(UInt256 *val, uint64_t *state);
+static double now_ns(void);
+static int same(UInt256 a, UInt256 b);
+static OpStats *stats_for(const char *name);
+static void mismatch(OpStats *st, size_t index, UInt256 left, UInt256 right, const char *what);
+
+static UInt256 left_pool[POOL_SIZE];
+static UInt256 right_pool[POOL_SIZE];
+static unsigned count_pool[POOL_SIZE];
+static UInt256 out_pool[POOL_SIZE];
+// index of the first pair in the current pool, for reporting mismatches
+static unsigned long pool_base;
+
+static OpStats all_stats[64];
+static int num_stats;
+
+// Keeps the compiler from optimizing away timed calls
+static volatile uint32_t sink;
+
+static void fuzz_binary(const char *name, BinaryOp op, BinaryOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  for (size_t i = 0; i < n; i++) {
+    if (!same(op(left_pool[i], right_pool[i]), ref(left_pool[i], right_pool[i]))) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc ^= op(left_pool[i], right_pool[i]).data[i & 7];
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+static void fuzz_unary(const char *name, UnaryOp op, UnaryOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  for (size_t i = 0; i < n; i++) {
+    if (!same(op(left_pool[i]), ref(left_pool[i]))) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc ^= op(left_pool[i]).data[i & 7];
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+static void fuzz_shift(const char *name, ShiftOp op, ShiftOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  for (size_t i = 0; i < n; i++) {
+    if (!same(op(left_pool[i], count_pool[i]), ref(left_pool[i], count_pool[i]))) {
+      char what[32];
+      snprintf(what, sizeof(what), " nbits=%u", count_pool[i]);
+      mismatch(st, i, left_pool[i], right_pool[i], what);
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc ^= op(left_pool[i], count_pool[i]).data[i & 7];
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+static void fuzz_count(const char *name, CountOp op, CountOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  for (size_t i = 0; i < n; i++) {
+    if (op(left_pool[i]) != ref(left_pool[i])) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc += op(left_pool[i]);
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+static void fuzz_compare(const char *name, CompareOp op, CompareOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  for (size_t i = 0; i < n; i++) {
+    // compare each value with itself too, since random pairs are almost never equal
+    if (op(left_pool[i], right_pool[i]) != ref(left_pool[i], right_pool[i]) ||
+        op(left_pool[i], left_pool[i]) != ref(left_pool[i], left_pool[i])) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc += (uint32_t) op(left_pool[i], right_pool[i]);
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+static void fuzz_mul_wide(size_t n) {
+  OpStats *st = stats_for("mul_wide");
+  for (size_t i = 0; i < n; i++) {
+    UInt512 a = uint256_mul_wide(left_pool[i], right_pool[i]);
+    UInt512 b = ref_mul_wide(left_pool[i], right_pool[i]);
+    if (memcmp(a.data, b.data, sizeof(a.data)) != 0) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    acc ^= uint256_mul_wide(left_pool[i], right_pool[i]).data[i & 15];
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+// The quotient and remainder are checked through num == quot*den + rem
+// with rem < den, which only they can satisfy.
+static void fuzz_divmod(size_t n) {
+  OpStats *st = stats_for("divmod");
+  for (size_t i = 0; i < n; i++) {
+    UInt256 num = left_pool[i], den = right_pool[i], quot, rem;
+    int status = uint256_divmod(num, den, &quot, &rem);
+    if (ref_eq(den, uint256_create_from_u32(0))) {
+      if (status != UINT256_ERR_DIV_BY_ZERO) {
+        mismatch(st, i, num, den, " (division by zero not reported)");
+      }
+      continue;
+    }
+    UInt512 prod = ref_mul_wide(quot, den);
+    UInt256 prod_lo, prod_hi;
+    memcpy(prod_lo.data, prod.data, sizeof(prod_lo.data));
+    memcpy(prod_hi.data, prod.data + 8, sizeof(prod_hi.data));
+    UInt256 total = ref_add(prod_lo, rem);
+    if (status != UINT256_OK || !ref_eq(prod_hi, uint256_create_from_u32(0)) ||
+        ref_cmp(total, prod_lo) < 0 || !ref_eq(total, num) || ref_cmp(rem, den) >= 0) {
+      mismatch(st, i, num, den, "");
+    } else if (!ref_eq(uint256_mod(num, den), rem)) {
+      mismatch(st, i, num, den, " (uint256_mod disagrees)");
+    }
+  }
+  st->checked += n;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    UInt256 quot, rem;
+    uint256_divmod(left_pool[i], right_pool[i], &quot, &rem);
+    acc ^= quot.data[i & 7] ^ rem.data[i & 7];
+  }
+  st->ns += now_ns() - start;
+  st->ops += n;
+  sink = acc;
+}
+
+// Montgomery multiplication with the right operand (made odd) as modulus
+static void fuzz_mont(size_t n) {
+  OpStats *st = stats_for("mont_mul");
+  UInt256 to_time[POOL_SIZE / MONT_STRIDE + 1];
+  UInt256MontCtx ctxs[POOL_SIZE / MONT_STRIDE + 1];
+  size_t count = 0;
+  for (size_t i = 0; i < n; i += MONT_STRIDE) {
+    UInt256 modulus = right_pool[i];
+    modulus.data[0] |= 1;
+    UInt256 a = left_pool[i], b = left_pool[(i + 1) % n];
+    if (uint256_mont_init(&ctxs[count], modulus) != UINT256_OK) {
+      mismatch(st, i, a, modulus, " (mont_init failed)");
+      continue;
+    }
+    UInt256 am = uint256_mont_to(&ctxs[count], a), bm = uint256_mont_to(&ctxs[count], b);
+    UInt256 result = uint256_mont_from(&ctxs[count], uint256_mont_mul(&ctxs[count], am, bm));
+    if (!same(result, ref_mulmod(a, b, modulus))) {
+      mismatch(st, i, a, modulus, "");
+    }
+    to_time[count++] = am;
+  }
+  st->checked += count;
+
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < count; i++) {
+    for (int k = 0; k < MONT_STRIDE; k++) {
+      to_time[i] = uint256_mont_mul(&ctxs[i], to_time[i], to_time[i]);
+    }
+    acc ^= to_time[i].data[0];
+  }
+  st->ns += now_ns() - start;
+  st->ops += count * MONT_STRIDE;
+  sink = acc;
+}
+
+static void fuzz_hex(size_t n) {
+  OpStats *fmt = stats_for("fmthex");
+  OpStats *parse = stats_for("parsehex");
+  for (size_t i = 0; i < n; i++) {
+    char expected[65], actual[65];
+    ref_format_hex(left_pool[i], expected);
+    size_t len = uint256_format_hex_into(left_pool[i], actual);
+    if (len != strlen(expected) || strcmp(expected, actual) != 0) {
+      mismatch(fmt, i, left_pool[i], right_pool[i], "");
+    }
+    UInt256 val;
+    if (uint256_parse_hex_n(expected, strlen(expected), &val) != UINT256_OK || !same(val, left_pool[i])) {
+      mismatch(parse, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  fmt->checked += n;
+  parse->checked += n;
+
+  static char strings[POOL_SIZE][65];
+  static size_t lengths[POOL_SIZE];
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    lengths[i] = uint256_format_hex_into(left_pool[i], strings[i]);
+  }
+  fmt->ns += now_ns() - start;
+  fmt->ops += n;
+  start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    UInt256 val;
+    uint256_parse_hex_n(strings[i], lengths[i], &val);
+    acc ^= val.data[i & 7];
+  }
+  parse->ns += now_ns() - start;
+  parse->ops += n;
+  sink = acc;
+}
+
+static void fuzz_dec(size_t n) {
+  OpStats *fmt = stats_for("fmtdec");
+  OpStats *parse = stats_for("parsedec");
+  for (size_t i = 0; i < n; i++) {
+    char expected[79], actual[79];
+    ref_format_dec(left_pool[i], expected);
+    size_t len = uint256_format_dec_into(left_pool[i], actual);
+    if (len != strlen(expected) || strcmp(expected, actual) != 0) {
+      mismatch(fmt, i, left_pool[i], right_pool[i], "");
+    }
+    UInt256 val;
+    if (uint256_parse_dec_n(expected, strlen(expected), &val) != UINT256_OK || !same(val, left_pool[i])) {
+      mismatch(parse, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  fmt->checked += n;
+  parse->checked += n;
+
+  static char strings[POOL_SIZE][79];
+  static size_t lengths[POOL_SIZE];
+  uint32_t acc = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    lengths[i] = uint256_format_dec_into(left_pool[i], strings[i]);
+  }
+  fmt->ns += now_ns() - start;
+  fmt->ops += n;
+  start = now_ns();
+  for (size_t i = 0; i < n; i++) {
+    UInt256 val;
+    uint256_parse_dec_n(strings[i], lengths[i], &val);
+    acc ^= val.data[i & 7];
+  }
+  parse->ns += now_ns() - start;
+  parse->ops += n;
+  sink = acc;
+}
+
+static void fuzz_batch(const char *name, BatchOp op, BinaryOp ref, size_t n) {
+  OpStats *st = stats_for(name);
+  // an odd length so the batch kernels' leftover handling is exercised too
+  size_t len = n - (n % 2 == 0);
+  op(left_pool, right_pool, out_pool, len);
+  for (size_t i = 0; i < len; i++) {
+    if (!same(out_pool[i], ref(left_pool[i], right_pool[i]))) {
+      mismatch(st, i, left_pool[i], right_pool[i], "");
+    }
+  }
+  st->checked += len;
+
+  double start = now_ns();
+  op(left_pool, right_pool, out_pool, len);
+  st->ns += now_ns() - start;
+  st->ops += len;
+  sink = out_pool[0].data[0];
+}
+
+// Adapters giving the remaining batch operations the BatchOp signature
+static void negate_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+  (void) b;
+  uint256_negate_n(a, out, n);
+}
+
+static void rotate_left_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+  uint256_rotate_left_n(a, b[0].data[0] % 512, out, n);
+}
+
+static void rotate_right_n(const UInt256 *a, const UInt256 *b, UInt256 *out, size_t n) {
+  uint256_rotate_right_n(a, b[0].data[0] % 512, out, n);
+}
+
+static UInt256 ref_negate_left(UInt256 left, UInt256 right) {
+  (void) right;
+  return ref_negate(left);
+}
+
+static UInt256 ref_rotate_left_first(UInt256 left, UInt256 right) {
+  (void) right;
+  return ref_rotate_left(left, right_pool[0].data[0] % 512);
+}
+
+static UInt256 ref_rotate_right_first(UInt256 left, UInt256 right) {
+  (void) right;
+  return ref_rotate_right(left, right_pool[0].data[0] % 512);
+}
+
+int main(int argc, char **argv) {
+  unsigned long pairs = DEFAULT_PAIRS;
+  uint64_t seed = 0x5eed0f0f5eed0f0fULL;
+  if (argc > 1) {
+    pairs = strtoul(argv[1], NULL, 10);
+  }
+  if (argc > 2) {
+    seed = strtoull(argv[2], NULL, 0);
+  }
+  if (pairs == 0 || argc > 3) {
+    fprintf(stderr, "Usage: %s [pairs] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  uint64_t state = seed | 1;
+  for (unsigned long done = 0; done < pairs; done += POOL_SIZE) {
+    size_t n = pairs - done < POOL_SIZE ? pairs - done : POOL_SIZE;
+    pool_base = done;
+    for (size_t i = 0; i < n; i++) {
+      random_operand(&left_pool[i], &state);
+      random_operand(&right_pool[i], &state);
+      // mostly in range, sometimes past 256 to check the out-of-range cases
+      uint32_t r = next_rand(&state);
+      count_pool[i] = (r & 0xF) == 0 ? r >> 4 : (r >> 4) % 257;
+    }
+
+    fuzz_binary("add", uint256_add, ref_add, n);
+    fuzz_binary("sub", uint256_sub, ref_sub, n);
+    fuzz_unary("negate", uint256_negate, ref_negate, n);
+    fuzz_binary("mul", uint256_mul, ref_mul, n);
+    fuzz_mul_wide(n);
+    fuzz_divmod(n);
+    fuzz_mont(n);
+    fuzz_binary("and", uint256_and, ref_and, n);
+    fuzz_binary("or", uint256_or, ref_or, n);
+    fuzz_binary("xor", uint256_xor, ref_xor, n);
+    fuzz_unary("not", uint256_not, ref_not, n);
+    fuzz_shift("shl", uint256_shl, ref_shl, n);
+    fuzz_shift("shr", uint256_shr, ref_shr, n);
+    fuzz_shift("rotl", uint256_rotate_left, ref_rotate_left, n);
+    fuzz_shift("rotr", uint256_rotate_right, ref_rotate_right, n);
+    fuzz_compare("cmp", uint256_cmp, ref_cmp, n);
+    fuzz_compare("eq", uint256_eq, ref_eq, n);
+    fuzz_count("clz", uint256_clz, ref_clz, n);
+    fuzz_count("ctz", uint256_ctz, ref_ctz, n);
+    fuzz_count("popcount", uint256_popcount, ref_popcount, n);
+    fuzz_hex(n);
+    fuzz_dec(n);
+    fuzz_batch("add_n", uint256_add_n, ref_add, n);
+    fuzz_batch("sub_n", uint256_sub_n, ref_sub, n);
+    fuzz_batch("negate_n", negate_n, ref_negate_left, n);
+    fuzz_batch("rotl_n", rotate_left_n, ref_rotate_left_first, n);
+    fuzz_batch("rotr_n", rotate_right_n, ref_rotate_right_first, n);
+  }
+
+  unsigned long total_mismatches = 0;
+  printf("%-9s %10s %10s %9s %9s\n", "op", "checked", "mismatch", "ns/op", "Mops/s");
+  for (int i = 0; i < num_stats; i++) {
+    OpStats *st = &all_stats[i];
+    double ns = st->ns / st->ops;
+    printf("%-9s %10lu %10lu %9.2f %9.2f\n", st->name, st->checked, st->mismatches, ns, 1e3 / ns);
+    total_mismatches += st->mismatches;
+  }
+  if (total_mismatches != 0) {
+    printf("FAILED: %lu mismatches\n", total_mismatches);
+    return 1;
+  }
+  printf("All operations agree with the reference\n");
+  return 0;
+}
+
+static Ref256 to_ref(UInt256 val) {
+  Ref256 ref = { 0, 0 };
+  for (int i = 3; i >= 0; i--) {
+    ref.lo = (ref.lo << 32) | val.data[i];
+    ref.hi = (ref.hi << 32) | val.data[i + 4];
+  }
+  return ref;
+}
+
+static UInt256 from_ref(Ref256 ref) {
+  UInt256 val;
+  for (int i = 0; i < 4; i++) {
+    val.data[i] = (uint32_t) (ref.lo >> (32 * i));
+    val.data[i + 4] = (uint32_t) (ref.hi >> (32 * i));
+  }
+  return val;
+}
+
+static UInt256 ref_add(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r;
+  r.lo = a.lo + b.lo;
+  r.hi = a.hi + b.hi + (r.lo < a.lo);
+  return from_ref(r);
+}
+
+static UInt256 ref_sub(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r;
+  r.lo = a.lo - b.lo;
+  r.hi = a.hi - b.hi - (a.lo < b.lo);
+  return from_ref(r);
+}
+
+static UInt256 ref_negate(UInt256 val) {
+  return ref_sub(uint256_create_from_u32(0), val);
+}
+
+// Full 256-bit product of two 128-bit values, from four 64x64 products.
+static u128 ref_mul128(u128 left, u128 right, u128 *hi) {
+  u128 l0 = (uint64_t) left, l1 = left >> 64;
+  u128 r0 = (uint64_t) right, r1 = right >> 64;
+  u128 p00 = l0 * r0, p01 = l0 * r1, p10 = l1 * r0, p11 = l1 * r1;
+  u128 mid = (p00 >> 64) + (uint64_t) p01 + (uint64_t) p10;
+  *hi = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+  return (mid << 64) | (uint64_t) p00;
+}
+
+static UInt256 ref_mul(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r;
+  u128 hi;
+  r.lo = ref_mul128(a.lo, b.lo, &hi);
+  // the cross products only contribute their low halves below 2^256
+  r.hi = hi + a.lo * b.hi + a.hi * b.lo;
+  return from_ref(r);
+}
+
+// Add x to *acc, returning the carry out.
+static unsigned ref_add128(u128 *acc, u128 x) {
+  *acc += x;
+  return *acc < x;
+}
+
+static UInt512 ref_mul_wide(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right);
+  u128 h0, h1, h2, h3;
+  u128 l0 = ref_mul128(a.lo, b.lo, &h0);
+  u128 l1 = ref_mul128(a.lo, b.hi, &h1);
+  u128 l2 = ref_mul128(a.hi, b.lo, &h2);
+  u128 l3 = ref_mul128(a.hi, b.hi, &h3);
+
+  // limbs of the product, each 128 bits
+  u128 r[4] = { l0, h0, l3, h3 };
+  unsigned carry = ref_add128(&r[1], l1) + ref_add128(&r[1], l2);
+  carry = ref_add128(&r[2], h1) + ref_add128(&r[2], h2) + ref_add128(&r[2], carry);
+  r[3] += carry;
+
+  UInt512 prod;
+  for (int limb = 0; limb < 4; limb++) {
+    for (int i = 0; i < 4; i++) {
+      prod.data[4 * limb + i] = (uint32_t) (r[limb] >> (32 * i));
+    }
+  }
+  return prod;
+}
+
+static UInt256 ref_and(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r = { a.lo & b.lo, a.hi & b.hi };
+  return from_ref(r);
+}
+
+static UInt256 ref_or(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r = { a.lo | b.lo, a.hi | b.hi };
+  return from_ref(r);
+}
+
+static UInt256 ref_xor(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right), r = { a.lo ^ b.lo, a.hi ^ b.hi };
+  return from_ref(r);
+}
+
+static UInt256 ref_not(UInt256 val) {
+  Ref256 a = to_ref(val), r = { ~a.lo, ~a.hi };
+  return from_ref(r);
+}
+
+static UInt256 ref_shl(UInt256 val, unsigned nbits) {
+  Ref256 a = to_ref(val), r = { 0, 0 };
+  if (nbits == 0) {
+    r = a;
+  } else if (nbits < 128) {
+    r.hi = (a.hi << nbits) | (a.lo >> (128 - nbits));
+    r.lo = a.lo << nbits;
+  } else if (nbits < 256) {
+    r.hi = a.lo << (nbits - 128);
+  }
+  return from_ref(r);
+}
+
+static UInt256 ref_shr(UInt256 val, unsigned nbits) {
+  Ref256 a = to_ref(val), r = { 0, 0 };
+  if (nbits == 0) {
+    r = a;
+  } else if (nbits < 128) {
+    r.lo = (a.lo >> nbits) | (a.hi << (128 - nbits));
+    r.hi = a.hi >> nbits;
+  } else if (nbits < 256) {
+    r.lo = a.hi >> (nbits - 128);
+  }
+  return from_ref(r);
+}
+
+static UInt256 ref_rotate_left(UInt256 val, unsigned nbits) {
+  nbits %= 256;
+  return ref_or(ref_shl(val, nbits), ref_shr(val, 256 - nbits));
+}
+
+static UInt256 ref_rotate_right(UInt256 val, unsigned nbits) {
+  nbits %= 256;
+  return ref_or(ref_shr(val, nbits), ref_shl(val, 256 - nbits));
+}
+
+static int ref_cmp(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right);
+  if (a.hi != b.hi) {
+    return a.hi < b.hi ? -1 : 1;
+  }
+  if (a.lo != b.lo) {
+    return a.lo < b.lo ? -1 : 1;
+  }
+  return 0;
+}
+
+static int ref_eq(UInt256 left, UInt256 right) {
+  Ref256 a = to_ref(left), b = to_ref(right);
+  return a.lo == b.lo && a.hi == b.hi;
+}
+
+// leading zeros of a 128-bit value, 128 for 0
+static unsigned ref_clz128(u128 x) {
+  unsigned n = 0;
+  while (n < 128 && !(x >> 127)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+}
+
+static unsigned ref_clz(UInt256 val) {
+  Ref256 a = to_ref(val);
+  return a.hi != 0 ? ref_clz128(a.hi) : 128 + ref_clz128(a.lo);
+}
+
+static unsigned ref_ctz(UInt256 val) {
+  Ref256 a = to_ref(val);
+  // isolate the lowest set bit, then count the bits below it
+  u128 low = a.lo != 0 ? a.lo : a.hi;
+  unsigned base = a.lo != 0 ? 0 : 128;
+  if (low == 0) {
+    return 256;
+  }
+  return base + 128 - ref_clz128(low & -low) - 1;
+}
+
+static unsigned ref_popcount(UInt256 val) {
+  Ref256 a = to_ref(val);
+  unsigned n = 0;
+  // clear the lowest set bit until none are left
+  for (u128 x = a.lo; x != 0; x &= x - 1) {
+    n++;
+  }
+  for (u128 x = a.hi; x != 0; x &= x - 1) {
+    n++;
+  }
+  return n;
+}
+
+// num mod den by shift-and-subtract, one bit at a time
+static UInt256 ref_mod(UInt256 num, UInt256 den) {
+  UInt256 rem = uint256_create_from_u32(0);
+  for (int bit = 255; bit >= 0; bit--) {
+    unsigned top = rem.data[7] >> 31;
+    rem = ref_shl(rem, 1);
+    rem.data[0] |= (num.data[bit / 32] >> (bit % 32)) & 1;
+    // if a bit was shifted out, rem is certainly >= den
+    if (top || ref_cmp(rem, den) >= 0) {
+      rem = ref_sub(rem, den);
+    }
+  }
+  return rem;
+}
+
+// left * right mod modulus by double-and-add
+static UInt256 ref_mulmod(UInt256 left, UInt256 right, UInt256 modulus) {
+  UInt256 a = ref_mod(left, modulus), b = ref_mod(right, modulus);
+  UInt256 result = uint256_create_from_u32(0);
+  for (int bit = 255; bit >= 0; bit--) {
+    // result = 2*result mod modulus, then add a if this bit of b is set;
+    // a carry out of 256 bits means the sum is past the modulus
+    unsigned carry = result.data[7] >> 31;
+    result = ref_shl(result, 1);
+    if (carry || ref_cmp(result, modulus) >= 0) {
+      result = ref_sub(result, modulus);
+    }
+    if ((b.data[bit / 32] >> (bit % 32)) & 1) {
+      UInt256 sum = ref_add(result, a);
+      if (ref_cmp(sum, result) < 0 || ref_cmp(sum, modulus) >= 0) {
+        sum = ref_sub(sum, modulus);
+      }
+      result = sum;
+    }
+  }
+  return result;
+}
+
+static void ref_format_hex(UInt256 val, char out[65]) {
+  char buf[65];
+  Ref256 a = to_ref(val);
+  snprintf(buf, sizeof(buf), "%016llx%016llx%016llx%016llx",
+           (unsigned long long) (a.hi >> 64), (unsigned long long) a.hi,
+           (unsigned long long) (a.lo >> 64), (unsigned long long) a.lo);
+  const char *p = buf;
+  while (p[0] == '0' && p[1] != '\0') {
+    p++;
+  }
+  strcpy(out, p);
+}
+
+static void ref_format_dec(UInt256 val, char out[79]) {
+  // divide the four 64-bit words by 10, most significant first
+  uint64_t words[4];
+  Ref256 a = to_ref(val);
+  words[0] = (uint64_t) a.lo;
+  words[1] = (uint64_t) (a.lo >> 64);
+  words[2] = (uint64_t) a.hi;
+  words[3] = (uint64_t) (a.hi >> 64);
+  char digits[78];
+  size_t n = 0;
+  int nonzero;
+  do {
+    u128 rem = 0;
+    nonzero = 0;
+    for (int i = 3; i >= 0; i--) {
+      u128 cur = (rem << 64) | words[i];
+      words[i] = (uint64_t) (cur / 10);
+      rem = cur % 10;
+      nonzero |= words[i] != 0;
+    }
+    digits[n++] = (char) ('0' + (int) rem);
+  } while (nonzero);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = digits[n - 1 - i];
+  }
+  out[n] = '\0';
+}
+
+// xorshift64* generator
+static uint32_t next_rand(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (uint32_t) ((*state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Random operand with a mix of shapes: full width, short (high words zero),
+// words that are all zeros or all ones, and single-bit values, so carries,
+// borrows and edge cases come up often.
+static void random_operand(UInt256 *val, uint64_t *state) {
+  uint32_t shape = next_rand(state);
+  for (int i = 0; i < 8; i++) {
+    val->data[i] = next_rand(state);
+  }
+  switch (shape % 8) {
+  case 0: {
+    // short value
+    unsigned words = (shape >> 3) % 8;
+    for (unsigned i = words; i < 8; i++) {
+      val->data[i] = 0;
+    }
+    break;
+  }
+  case 1:
+    // sprinkle in all-zero and all-ones words
+    for (int i = 0; i < 8; i++) {
+      uint32_t pick = (shape >> (3 + 2 * i)) & 3;
+      if (pick == 0) {
+        val->data[i] = 0;
+      } else if (pick == 1) {
+        val->data[i] = 0xFFFFFFFFU;
+      }
+    }
+    break;
+  case 2:
+    // a single bit
+    for (int i = 0; i < 8; i++) {
+      val->data[i] = 0;
+    }
+    val->data[(shape >> 3) % 8] = 1U << ((shape >> 6) % 32);
+    break;
+  default:
+    break;
+  }
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int same(UInt256 a, UInt256 b) {
+  return memcmp(a.data, b.data, sizeof(a.data)) == 0;
+}
+
+// Find (or add) the stats entry for an operation; entries keep the order
+// the operations are first run in.
+static OpStats *stats_for(const char *name) {
+  for (int i = 0; i < num_stats; i++) {
+    if (strcmp(all_stats[i].name, name) == 0) {
+      return &all_stats[i];
+    }
+  }
+  OpStats *st = &all_stats[num_stats++];
+  st->name = name;
+  return st;
+}
+
+// Record a mismatch, printing the operands of the first few.
+static void mismatch(OpStats *st, size_t index, UInt256 left, UInt256 right, const char *what) {
+  if (st->mismatches++ < MAX_REPORTED) {
+    char l[65], r[65];
+    uint256_format_hex_into(left, l);
+    uint256_format_hex_into(right, r);
+    printf("%s mismatch at pair %lu%s: left=%s right=%s\n", st->name, pool_base + index, what, l, r);
+  }
+}
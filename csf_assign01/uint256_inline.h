@@ -0,0 +1,504 @@
+#ifndef UINT256_INLINE_H
+#define UINT256_INLINE_H
+
+// Header-only (static inline) versions of the core UInt256 operations.
+// The functions in uint256.c take and return 32-byte structs by value
+// across a call, which keeps values in memory; including this header
+// instead lets the compiler inline them and keep values in registers.
+// The out-of-line functions in uint256.c are built from these, so both
+// versions always give the same results.
+//
+// For C++ (C++14 or later) there is also a UInt256Value wrapper class
+// with constexpr operators, so constants can be computed at compile time.
+
+#include <stdint.h>
+#include "uint256.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define UINT256_HAVE_ADDCARRY_U64 1
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+#define UINT256_HAVE_BUILTIN_ADDCLL 1
+#endif
+#endif
+
+// Read the 64-bit word made up of data[2*index] (low half) and
+// data[2*index+1] (high half).
+static inline uint64_t uint256_load_u64(const UInt256 *val, unsigned index) {
+  return (uint64_t) val->data[2*index] | ((uint64_t) val->data[2*index + 1] << 32);
+}
+
+// Write a 64-bit word back into data[2*index] and data[2*index+1].
+static inline void uint256_store_u64(UInt256 *val, unsigned index, uint64_t word) {
+  val->data[2*index] = (uint32_t) word;
+  val->data[2*index + 1] = (uint32_t) (word >> 32);
+}
+
+// Add two 64-bit words and the incoming carry (0 or 1). The outgoing
+// carry is stored back into *carry, without any branches.
+static inline uint64_t uint256_add64_carry(uint64_t left, uint64_t right, unsigned *carry) {
+#if defined(UINT256_HAVE_BUILTIN_ADDCLL)
+  unsigned long long carry_out;
+  uint64_t sum = __builtin_addcll(left, right, *carry, &carry_out);
+  *carry = (unsigned) carry_out;
+  return sum;
+#elif defined(UINT256_HAVE_ADDCARRY_U64)
+  unsigned long long sum;
+  *carry = _addcarry_u64((unsigned char) *carry, left, right, &sum);
+  return sum;
+#else
+  uint64_t partial = left + right;
+  uint64_t sum = partial + *carry;
+  // at most one of the two additions can wrap around
+  *carry = (partial < left) | (sum < partial);
+  return sum;
+#endif
+}
+
+// Subtract right and the incoming borrow (0 or 1) from left. The outgoing
+// borrow is stored back into *borrow, without any branches.
+static inline uint64_t uint256_sub64_borrow(uint64_t left, uint64_t right, unsigned *borrow) {
+#if defined(UINT256_HAVE_BUILTIN_ADDCLL)
+  unsigned long long borrow_out;
+  uint64_t diff = __builtin_subcll(left, right, *borrow, &borrow_out);
+  *borrow = (unsigned) borrow_out;
+  return diff;
+#elif defined(UINT256_HAVE_ADDCARRY_U64)
+  unsigned long long diff;
+  *borrow = _subborrow_u64((unsigned char) *borrow, left, right, &diff);
+  return diff;
+#else
+  uint64_t partial = left - right;
+  uint64_t diff = partial - *borrow;
+  // at most one of the two subtractions can wrap around
+  *borrow = (left < right) | (partial < *borrow);
+  return diff;
+#endif
+}
+
+// Create a UInt256 value from a single uint32_t value.
+static inline UInt256 uint256_inline_create_from_u32(uint32_t val) {
+  UInt256 result;
+  result.data[0] = val;
+  for (int x = 1; x < 8; x++) {
+    result.data[x] = 0;
+  }
+  return result;
+}
+
+// Create a UInt256 value from an array of 8 uint32_t values.
+static inline UInt256 uint256_inline_create(const uint32_t data[8]) {
+  UInt256 result;
+  for (int x = 0; x < 8; x++) {
+    result.data[x] = data[x];
+  }
+  return result;
+}
+
+// Get 32 bits of data from a UInt256 value.
+static inline uint32_t uint256_inline_get_bits(UInt256 val, unsigned index) {
+  return val.data[index];
+}
+
+// Compute the sum of two UInt256 values.
+static inline UInt256 uint256_inline_add(UInt256 left, UInt256 right) {
+  UInt256 sum;
+  unsigned carry = 0;
+  // work on 64 bits at a time so there are only four carry steps instead of eight
+  for (unsigned x = 0; x < 4; x++) {
+    uint64_t cur_sum = uint256_add64_carry(uint256_load_u64(&left, x), uint256_load_u64(&right, x), &carry);
+    uint256_store_u64(&sum, x, cur_sum);
+  }
+  return sum;
+}
+
+// Compute the difference of two UInt256 values.
+static inline UInt256 uint256_inline_sub(UInt256 left, UInt256 right) {
+  UInt256 result;
+  unsigned borrow = 0;
+  // propagate the borrow directly instead of adding the negation of right
+  for (unsigned x = 0; x < 4; x++) {
+    uint64_t cur_diff = uint256_sub64_borrow(uint256_load_u64(&left, x), uint256_load_u64(&right, x), &borrow);
+    uint256_store_u64(&result, x, cur_diff);
+  }
+  return result;
+}
+
+// Return the two's-complement negation of the given UInt256 value.
+static inline UInt256 uint256_inline_negate(UInt256 val) {
+  // -val is the same as 0 - val, which needs just one borrow chain
+  return uint256_inline_sub(uint256_inline_create_from_u32(0), val);
+}
+
+// Each output word of a shift or rotate is a "funnel shift" of two
+// neighboring source words: the words nbits/32 positions away supply
+// the high bits and the word one further supplies the low bits. Laying
+// the source out in a 16-word buffer (padded with zeros for shifts, or
+// repeated for rotates) lets every output word be computed directly, so
+// the work done is the same for every shift count.
+
+// Combine word hi shifted left by bits with the bits of lo that spill
+// into it. Written as two shifts so that bits == 0 never shifts by 32.
+static inline uint32_t uint256_funnel_left(uint32_t hi, uint32_t lo, unsigned bits) {
+  return (hi << bits) | ((lo >> 1) >> (31 - bits));
+}
+
+// Combine word lo shifted right by bits with the bits of hi that spill
+// into it.
+static inline uint32_t uint256_funnel_right(uint32_t hi, uint32_t lo, unsigned bits) {
+  return (lo >> bits) | ((hi << 1) << (31 - bits));
+}
+
+// Return val shifted left by nbits (0 if nbits >= 256).
+static inline UInt256 uint256_inline_shl(UInt256 val, unsigned nbits) {
+  uint32_t ext[16];
+  for (int i = 0; i < 8; i++) {
+    ext[i] = 0;
+    ext[i + 8] = val.data[i];
+  }
+  // all ones if nbits < 256, otherwise all zeros
+  uint32_t keep = (uint32_t) 0 - (nbits < 256);
+  unsigned words = (nbits / 32) & 7;
+  unsigned bits = nbits % 32;
+  UInt256 result;
+  for (unsigned i = 0; i < 8; i++) {
+    result.data[i] = uint256_funnel_left(ext[8 + i - words], ext[7 + i - words], bits) & keep;
+  }
+  return result;
+}
+
+// Return val shifted right by nbits (0 if nbits >= 256).
+static inline UInt256 uint256_inline_shr(UInt256 val, unsigned nbits) {
+  uint32_t ext[16];
+  for (int i = 0; i < 8; i++) {
+    ext[i] = val.data[i];
+    ext[i + 8] = 0;
+  }
+  uint32_t keep = (uint32_t) 0 - (nbits < 256);
+  unsigned words = (nbits / 32) & 7;
+  unsigned bits = nbits % 32;
+  UInt256 result;
+  for (unsigned i = 0; i < 8; i++) {
+    result.data[i] = uint256_funnel_right(ext[i + words + 1], ext[i + words], bits) & keep;
+  }
+  return result;
+}
+
+// Return the result of rotating every bit in val nbits to the left.
+static inline UInt256 uint256_inline_rotate_left(UInt256 val, unsigned nbits) {
+  uint32_t ext[16];
+  for (int i = 0; i < 8; i++) {
+    ext[i] = val.data[i];
+    ext[i + 8] = val.data[i];
+  }
+  // if shifting more than 256, just circles back to shifting a small amount (257 = shifting 1 bit)
+  nbits = nbits % 256;
+  unsigned words = nbits / 32;
+  unsigned bits = nbits % 32;
+  UInt256 result;
+  for (unsigned i = 0; i < 8; i++) {
+    result.data[i] = uint256_funnel_left(ext[8 + i - words], ext[7 + i - words], bits);
+  }
+  return result;
+}
+
+// Return the result of rotating every bit in val nbits to the right.
+static inline UInt256 uint256_inline_rotate_right(UInt256 val, unsigned nbits) {
+  uint32_t ext[16];
+  for (int i = 0; i < 8; i++) {
+    ext[i] = val.data[i];
+    ext[i + 8] = val.data[i];
+  }
+  nbits = nbits % 256;
+  unsigned words = nbits / 32;
+  unsigned bits = nbits % 32;
+  UInt256 result;
+  for (unsigned i = 0; i < 8; i++) {
+    result.data[i] = uint256_funnel_right(ext[i + words + 1], ext[i + words], bits);
+  }
+  return result;
+}
+
+// Compare two UInt256 values, returning -1 if left < right, 0 if they
+// are equal and 1 if left > right.
+static inline int uint256_inline_cmp(UInt256 left, UInt256 right) {
+  // Bit k of lt (gt) is set if 64-bit word k of left is less (greater)
+  // than that of right. Comparing the two masks as integers then gives
+  // the answer, since the most significant differing word decides it.
+  unsigned lt = 0, gt = 0;
+  for (unsigned x = 0; x < 4; x++) {
+    uint64_t l = uint256_load_u64(&left, x), r = uint256_load_u64(&right, x);
+    lt |= (unsigned) (l < r) << x;
+    gt |= (unsigned) (l > r) << x;
+  }
+  return (gt > lt) - (gt < lt);
+}
+
+// Return 1 if left and right are equal, 0 otherwise.
+static inline int uint256_inline_eq(UInt256 left, UInt256 right) {
+  uint32_t diff = 0;
+  for (int i = 0; i < 8; i++) {
+    diff |= left.data[i] ^ right.data[i];
+  }
+  return diff == 0;
+}
+
+// Bitwise AND of two UInt256 values.
+static inline UInt256 uint256_inline_and(UInt256 left, UInt256 right) {
+  UInt256 result;
+  for (int i = 0; i < 8; i++) {
+    result.data[i] = left.data[i] & right.data[i];
+  }
+  return result;
+}
+
+// Bitwise OR of two UInt256 values.
+static inline UInt256 uint256_inline_or(UInt256 left, UInt256 right) {
+  UInt256 result;
+  for (int i = 0; i < 8; i++) {
+    result.data[i] = left.data[i] | right.data[i];
+  }
+  return result;
+}
+
+// Bitwise XOR of two UInt256 values.
+static inline UInt256 uint256_inline_xor(UInt256 left, UInt256 right) {
+  UInt256 result;
+  for (int i = 0; i < 8; i++) {
+    result.data[i] = left.data[i] ^ right.data[i];
+  }
+  return result;
+}
+
+// Bitwise complement of a UInt256 value.
+static inline UInt256 uint256_inline_not(UInt256 val) {
+  UInt256 result;
+  for (int i = 0; i < 8; i++) {
+    result.data[i] = ~val.data[i];
+  }
+  return result;
+}
+
+// Leading/trailing zero counts and population count of a single 64-bit
+// word. The zero counts are only called on words with the low (high) bit
+// forced on, since the builtins are undefined for 0.
+#if defined(__GNUC__) || defined(__clang__)
+#define uint256_clz64(word) ((unsigned) __builtin_clzll(word))
+#define uint256_ctz64(word) ((unsigned) __builtin_ctzll(word))
+#else
+static inline unsigned uint256_clz64(uint64_t word) {
+  unsigned n = 0;
+  while (!(word & 0x8000000000000000ULL)) {
+    word <<= 1;
+    n++;
+  }
+  return n;
+}
+
+static inline unsigned uint256_ctz64(uint64_t word) {
+  unsigned n = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
+static inline unsigned uint256_popcount64(uint64_t word) {
+#if defined(__POPCNT__)
+  return (unsigned) __builtin_popcountll(word);
+#else
+  // without the popcnt instruction the builtin becomes a library call,
+  // so count bits in parallel instead
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (unsigned) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Return the number of leading (most significant) zero bits in val,
+// 256 if val is 0.
+static inline unsigned uint256_inline_clz(UInt256 val) {
+  unsigned count = 0;
+  // all ones once a nonzero word has been seen
+  unsigned found = 0;
+  for (int x = 3; x >= 0; x--) {
+    uint64_t word = uint256_load_u64(&val, (unsigned) x);
+    // clz(word | 1) is right for any nonzero word and 63 for 0, so add 1 for 0
+    unsigned word_count = uint256_clz64(word | 1) + (word == 0);
+    count += word_count & ~found;
+    found |= 0U - (word != 0);
+  }
+  return count;
+}
+
+// Return the number of trailing (least significant) zero bits in val,
+// 256 if val is 0.
+static inline unsigned uint256_inline_ctz(UInt256 val) {
+  unsigned count = 0;
+  unsigned found = 0;
+  for (unsigned x = 0; x < 4; x++) {
+    uint64_t word = uint256_load_u64(&val, x);
+    unsigned word_count = uint256_ctz64(word | 0x8000000000000000ULL) + (word == 0);
+    count += word_count & ~found;
+    found |= 0U - (word != 0);
+  }
+  return count;
+}
+
+// Return the number of 1 bits in val.
+static inline unsigned uint256_inline_popcount(UInt256 val) {
+  unsigned count = 0;
+  for (unsigned x = 0; x < 4; x++) {
+    count += uint256_popcount64(uint256_load_u64(&val, x));
+  }
+  return count;
+}
+
+#if defined(__cplusplus) && __cplusplus >= 201402L
+
+// Value wrapper around UInt256 whose operations are all constexpr, so
+// expressions on constants are folded at compile time. The arithmetic is
+// done on 32-bit words with 64-bit intermediates (intrinsics can't be used
+// in constant expressions), which compilers turn into carry chains anyway.
+class UInt256Value {
+public:
+  constexpr UInt256Value() : m_val{} { }
+  constexpr UInt256Value(uint32_t val) : m_val{{val, 0, 0, 0, 0, 0, 0, 0}} { }
+  constexpr UInt256Value(const UInt256 &val) : m_val(val) { }
+
+  // Create a value from 8 words, least significant first.
+  static constexpr UInt256Value from_words(const uint32_t (&data)[8]) {
+    UInt256 val{};
+    for (int i = 0; i < 8; i++) {
+      val.data[i] = data[i];
+    }
+    return UInt256Value(val);
+  }
+
+  constexpr UInt256 get() const { return m_val; }
+  constexpr uint32_t get_bits(unsigned index) const { return m_val.data[index]; }
+
+  friend constexpr UInt256Value operator+(const UInt256Value &left, const UInt256Value &right) {
+    UInt256 sum{};
+    uint64_t carry = 0;
+    for (int i = 0; i < 8; i++) {
+      uint64_t cur = (uint64_t) left.m_val.data[i] + right.m_val.data[i] + carry;
+      sum.data[i] = (uint32_t) cur;
+      carry = cur >> 32;
+    }
+    return UInt256Value(sum);
+  }
+
+  friend constexpr UInt256Value operator-(const UInt256Value &left, const UInt256Value &right) {
+    UInt256 diff{};
+    uint64_t borrow = 0;
+    for (int i = 0; i < 8; i++) {
+      uint64_t cur = (uint64_t) left.m_val.data[i] - right.m_val.data[i] - borrow;
+      diff.data[i] = (uint32_t) cur;
+      // a wrapped-around difference has its upper half all ones
+      borrow = (cur >> 32) & 1;
+    }
+    return UInt256Value(diff);
+  }
+
+  constexpr UInt256Value operator-() const { return UInt256Value() - *this; }
+
+  // Bitwise operators, applied word by word.
+  friend constexpr UInt256Value operator&(const UInt256Value &left, const UInt256Value &right) {
+    return combine(left, right, BitOp::And);
+  }
+  friend constexpr UInt256Value operator|(const UInt256Value &left, const UInt256Value &right) {
+    return combine(left, right, BitOp::Or);
+  }
+  friend constexpr UInt256Value operator^(const UInt256Value &left, const UInt256Value &right) {
+    return combine(left, right, BitOp::Xor);
+  }
+  constexpr UInt256Value operator~() const { return *this ^ (UInt256Value() - UInt256Value(1U)); }
+
+  // Shifts; bits shifted out are lost and a shift of 256 or more gives 0.
+  constexpr UInt256Value operator<<(unsigned nbits) const {
+    UInt256 result{};
+    for (int i = 0; i < 8; i++) {
+      result.data[i] = word_at(i - (int) (nbits / 32), 0) << (nbits % 32) |
+                       (uint32_t) ((uint64_t) word_at(i - (int) (nbits / 32) - 1, 0) >> (32 - nbits % 32));
+    }
+    return UInt256Value(result);
+  }
+
+  constexpr UInt256Value operator>>(unsigned nbits) const {
+    UInt256 result{};
+    for (int i = 0; i < 8; i++) {
+      result.data[i] = word_at(i + (int) (nbits / 32), 0) >> (nbits % 32) |
+                       (uint32_t) ((uint64_t) word_at(i + (int) (nbits / 32) + 1, 0) << (32 - nbits % 32));
+    }
+    return UInt256Value(result);
+  }
+
+  constexpr UInt256Value rotate_left(unsigned nbits) const {
+    nbits %= 256;
+    return (*this << nbits) | (*this >> (256 - nbits));
+  }
+
+  constexpr UInt256Value rotate_right(unsigned nbits) const {
+    nbits %= 256;
+    return (*this >> nbits) | (*this << (256 - nbits));
+  }
+
+  // -1, 0 or 1 like uint256_inline_cmp
+  constexpr int compare(const UInt256Value &other) const {
+    for (int i = 7; i >= 0; i--) {
+      if (m_val.data[i] != other.m_val.data[i]) {
+        return m_val.data[i] < other.m_val.data[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  friend constexpr bool operator==(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) == 0; }
+  friend constexpr bool operator!=(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) != 0; }
+  friend constexpr bool operator<(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) < 0; }
+  friend constexpr bool operator<=(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) <= 0; }
+  friend constexpr bool operator>(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) > 0; }
+  friend constexpr bool operator>=(const UInt256Value &left, const UInt256Value &right) { return left.compare(right) >= 0; }
+
+private:
+  UInt256 m_val;
+
+  // word i of the value, or fill if i is out of range
+  constexpr uint32_t word_at(int i, uint32_t fill) const {
+    return (i >= 0 && i < 8) ? m_val.data[i] : fill;
+  }
+
+  // the bitwise operations combine can apply
+  enum class BitOp { And, Or, Xor };
+
+  // apply op word by word
+  static constexpr UInt256Value combine(const UInt256Value &left, const UInt256Value &right, BitOp op) {
+    UInt256 result{};
+    for (int i = 0; i < 8; i++) {
+      uint32_t l = left.m_val.data[i], r = right.m_val.data[i];
+      switch (op) {
+      case BitOp::And:
+        result.data[i] = l & r;
+        break;
+      case BitOp::Or:
+        result.data[i] = l | r;
+        break;
+      case BitOp::Xor:
+        result.data[i] = l ^ r;
+        break;
+      }
+    }
+    return UInt256Value(result);
+  }
+};
+
+#endif // __cplusplus >= 201402L
+
+#endif // UINT256_INLINE_H
@@ -15,6 +15,10 @@ typedef struct {
 
 // Helper functions for implementing tests
 void set_all(UInt256 *val, uint32_t wordval);
+uint32_t test_rand(uint64_t *state);
+void random_uint256(UInt256 *val, uint64_t *state);
+void ref_mul_wide(UInt256 left, UInt256 right, uint32_t prod[16]);
+int is_less(UInt256 left, UInt256 right);
 
 #define ASSERT_SAME(expected, actual) \
 do { \
@@ -47,8 +51,28 @@ void test_create_from_u32(TestObjs *objs);
 void test_create(TestObjs *objs);
 void test_create_from_hex(TestObjs *objs);
 void test_format_as_hex(TestObjs *objs);
+void test_parse_hex_n(TestObjs *objs);
+void test_format_hex_into(TestObjs *objs);
+void test_create_from_dec(TestObjs *objs);
+void test_format_as_dec(TestObjs *objs);
+void test_dec_round_trip(TestObjs *objs);
 void test_rotate_left(TestObjs *objs);
 void test_rotate_right(TestObjs *objs);
+void test_shl(TestObjs *objs);
+void test_shr(TestObjs *objs);
+void test_shift_rotate_random(TestObjs *objs);
+void test_cmp_eq(TestObjs *objs);
+void test_bitwise(TestObjs *objs);
+void test_bit_counts(TestObjs *objs);
+void test_mul(TestObjs *objs);
+void test_mul_wide(TestObjs *objs);
+void test_mul_random(TestObjs *objs);
+void test_divmod(TestObjs *objs);
+void test_divmod_random(TestObjs *objs);
+void test_mont(TestObjs *objs);
+void test_mont_pow_random(TestObjs *objs);
+void test_add_sub_n(TestObjs *objs);
+void test_negate_rotate_n(TestObjs *objs);
 
 int main(int argc, char **argv) {
   if (argc > 1) {
@@ -65,8 +89,28 @@ int main(int argc, char **argv) {
   TEST(test_create);
   TEST(test_create_from_hex);
   TEST(test_format_as_hex);
+  TEST(test_parse_hex_n);
+  TEST(test_format_hex_into);
+  TEST(test_create_from_dec);
+  TEST(test_format_as_dec);
+  TEST(test_dec_round_trip);
   TEST(test_rotate_left);
   TEST(test_rotate_right);
+  TEST(test_shl);
+  TEST(test_shr);
+  TEST(test_shift_rotate_random);
+  TEST(test_cmp_eq);
+  TEST(test_bitwise);
+  TEST(test_bit_counts);
+  TEST(test_mul);
+  TEST(test_mul_wide);
+  TEST(test_mul_random);
+  TEST(test_divmod);
+  TEST(test_divmod_random);
+  TEST(test_mont);
+  TEST(test_mont_pow_random);
+  TEST(test_add_sub_n);
+  TEST(test_negate_rotate_n);
 
   TEST_FINI();
 }
@@ -78,6 +122,57 @@ void set_all(UInt256 *val, uint32_t wordval) {
   }
 }
 
+// xorshift64* generator so random tests are repeatable
+uint32_t test_rand(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (uint32_t) ((*state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Fill a UInt256 with random words, sometimes leaving high words zero
+// or saturated so that short operands and long carry chains both show up
+void random_uint256(UInt256 *val, uint64_t *state) {
+  uint32_t shape = test_rand(state);
+  unsigned top = shape % 8;
+  for (unsigned i = 0; i < 8; ++i) {
+    if (i > top && (shape & 0x100)) {
+      val->data[i] = 0;
+    } else if (shape & 0x200) {
+      val->data[i] = 0xFFFFFFFFU;
+    } else {
+      val->data[i] = test_rand(state);
+    }
+  }
+}
+
+// Reference big-integer multiplication using plain 32-bit limbs and
+// 64-bit partial products, to check uint256_mul/uint256_mul_wide against
+void ref_mul_wide(UInt256 left, UInt256 right, uint32_t prod[16]) {
+  for (unsigned i = 0; i < 16; ++i) {
+    prod[i] = 0;
+  }
+  for (unsigned i = 0; i < 8; ++i) {
+    uint64_t carry = 0;
+    for (unsigned j = 0; j < 8; ++j) {
+      uint64_t t = (uint64_t) left.data[i] * right.data[j] + prod[i + j] + carry;
+      prod[i + j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+    prod[i + 8] = (uint32_t) carry;
+  }
+}
+
+// Return 1 if left < right as unsigned 256-bit values
+int is_less(UInt256 left, UInt256 right) {
+  for (int i = 7; i >= 0; --i) {
+    if (left.data[i] != right.data[i]) {
+      return left.data[i] < right.data[i];
+    }
+  }
+  return 0;
+}
+
 TestObjs *setup(void) {
   TestObjs *objs = (TestObjs *) malloc(sizeof(TestObjs));
 
@@ -239,6 +334,22 @@ void test_create_from_hex(TestObjs *objs) {
   // test create_from_hex on empty string returns zero
   UInt256 zero_test = uint256_create_from_hex("");
   ASSERT_SAME(objs->zero, zero_test);
+
+  // each group of 8 characters is read like strtoul reads it: leading
+  // whitespace, a 0x prefix and anything after the digits are accepted
+  UInt256 small;
+  ASSERT(UINT256_OK == uint256_parse_hex_n("1f", 2, &small));
+  ASSERT_SAME(small, uint256_create_from_hex("0x1F"));
+  ASSERT_SAME(small, uint256_create_from_hex("1f "));
+  ASSERT(UINT256_OK == uint256_parse_hex_n("ff", 2, &small));
+  ASSERT_SAME(small, uint256_create_from_hex("  ff"));
+  ASSERT(UINT256_OK == uint256_parse_hex_n("12", 2, &small));
+  ASSERT_SAME(small, uint256_create_from_hex("12g4"));
+  // groups are independent: an invalid character only cuts its own group short
+  uint32_t array3[8] = {0x12345678U, 0x12U, 0, 0, 0, 0, 0, 0 };
+  ASSERT_SAME(uint256_create(array3), uint256_create_from_hex("12g4567812345678"));
+  // and characters before the rightmost 64 are ignored, even invalid ones
+  ASSERT_SAME(objs->one, uint256_create_from_hex("zz0000000000000000000000000000000000000000000000000000000000000001"));
 }
 
 void test_format_as_hex(TestObjs *objs) {
@@ -277,6 +388,162 @@ void test_format_as_hex(TestObjs *objs) {
   free(s);
 }
 
+void test_parse_hex_n(TestObjs *objs) {
+  UInt256 result;
+
+  ASSERT(UINT256_OK == uint256_parse_hex_n("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", 64, &result));
+  ASSERT_SAME(objs->max, result);
+
+  // only len characters are read, so the string doesn't need a NUL terminator
+  ASSERT(UINT256_OK == uint256_parse_hex_n("1zzz", 1, &result));
+  ASSERT_SAME(objs->one, result);
+
+  // upper case digits work too
+  ASSERT(UINT256_OK == uint256_parse_hex_n("CD000000" "00000000" "00000000" "00000000" "00000000" "00000000" "00000000" "000000AB", 64, &result));
+  ASSERT_SAME(objs->rot, result);
+
+  // empty input is zero
+  ASSERT(UINT256_OK == uint256_parse_hex_n("", 0, &result));
+  ASSERT_SAME(objs->zero, result);
+
+  uint32_t array[8] = {1454099951, 4660, 0, 0, 0, 0, 0, 0 };
+  UInt256 expected = uint256_create(array);
+  ASSERT(UINT256_OK == uint256_parse_hex_n("123456AbCdEf", 12, &result));
+  ASSERT_SAME(expected, result);
+
+  // invalid characters are reported and give zero, even beyond the 64th digit
+  ASSERT(UINT256_ERR_INVALID_DIGIT == uint256_parse_hex_n("12g4", 4, &result));
+  ASSERT_SAME(objs->zero, result);
+  ASSERT(UINT256_ERR_INVALID_DIGIT == uint256_parse_hex_n("x0000000000000000000000000000000000000000000000000000000000000001", 65, &result));
+  ASSERT_SAME(objs->zero, result);
+  ASSERT(UINT256_ERR_INVALID_DIGIT == uint256_parse_hex_n("1 2", 3, &result));
+}
+
+void test_format_hex_into(TestObjs *objs) {
+  char buf[65];
+
+  ASSERT(1 == uint256_format_hex_into(objs->zero, buf));
+  ASSERT(0 == strcmp("0", buf));
+
+  ASSERT(1 == uint256_format_hex_into(objs->one, buf));
+  ASSERT(0 == strcmp("1", buf));
+
+  ASSERT(64 == uint256_format_hex_into(objs->max, buf));
+  ASSERT(0 == strcmp("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", buf));
+
+  ASSERT(64 == uint256_format_hex_into(objs->rot, buf));
+  ASSERT(0 == strcmp("cd000000000000000000000000000000000000000000000000000000000000ab", buf));
+
+  // zero words below the top word keep all of their digits
+  uint32_t array[8] = {0, 0, 0, 0, 0x10, 0, 0, 0};
+  UInt256 val = uint256_create(array);
+  ASSERT(34 == uint256_format_hex_into(val, buf));
+  ASSERT(0 == strcmp("1000000000000000000000000000000000", buf));
+
+  // formatting and parsing round trip
+  uint64_t state = 0xabcdef0123456789ULL;
+  for (unsigned iter = 0; iter < 1000; ++iter) {
+    UInt256 orig, parsed;
+    random_uint256(&orig, &state);
+    size_t len = uint256_format_hex_into(orig, buf);
+    ASSERT(len == strlen(buf));
+    ASSERT(len == 1 || buf[0] != '0');
+    ASSERT(UINT256_OK == uint256_parse_hex_n(buf, len, &parsed));
+    ASSERT_SAME(orig, parsed);
+  }
+}
+
+void test_create_from_dec(TestObjs *objs) {
+  UInt256 result;
+
+  result = uint256_create_from_dec("0");
+  ASSERT_SAME(objs->zero, result);
+
+  result = uint256_create_from_dec("1");
+  ASSERT_SAME(objs->one, result);
+
+  result = uint256_create_from_dec("");
+  ASSERT_SAME(objs->zero, result);
+
+  result = uint256_create_from_dec("115792089237316195423570985008687907853269984665640564039457584007913129639935");
+  ASSERT_SAME(objs->max, result);
+
+  result = uint256_create_from_dec("57896044618658097711785492504343953926634992332820282019728792003956564819968");
+  ASSERT_SAME(objs->msb_set, result);
+
+  // leading zeros are allowed
+  result = uint256_create_from_dec("0000000000000000000000000000000000000000000000000000000000000000000000000000000000001");
+  ASSERT_SAME(objs->one, result);
+
+  // exactly one 19-digit chunk, and one digit more
+  result = uint256_create_from_dec("9999999999999999999");
+  ASSERT_SAME(uint256_create_from_hex("8ac7230489e7ffff"), result);
+  result = uint256_create_from_dec("10000000000000000000");
+  ASSERT_SAME(uint256_create_from_hex("8ac7230489e80000"), result);
+
+  // 2^256 doesn't fit
+  ASSERT(UINT256_ERR_OVERFLOW == uint256_parse_dec_n("115792089237316195423570985008687907853269984665640564039457584007913129639936", 78, &result));
+  ASSERT_SAME(objs->zero, result);
+  ASSERT(UINT256_ERR_INVALID_DIGIT == uint256_parse_dec_n("12a4", 4, &result));
+  ASSERT_SAME(objs->zero, result);
+  ASSERT(UINT256_ERR_INVALID_DIGIT == uint256_parse_dec_n("-1", 2, &result));
+
+  // only len characters are read
+  ASSERT(UINT256_OK == uint256_parse_dec_n("12xyz", 2, &result));
+  ASSERT_SAME(uint256_create_from_u32(12), result);
+}
+
+void test_format_as_dec(TestObjs *objs) {
+  char *s;
+
+  s = uint256_format_as_dec(objs->zero);
+  ASSERT(0 == strcmp("0", s));
+  free(s);
+
+  s = uint256_format_as_dec(objs->one);
+  ASSERT(0 == strcmp("1", s));
+  free(s);
+
+  s = uint256_format_as_dec(objs->max);
+  ASSERT(0 == strcmp("115792089237316195423570985008687907853269984665640564039457584007913129639935", s));
+  free(s);
+
+  s = uint256_format_as_dec(objs->rot);
+  ASSERT(0 == strcmp("92724133959569609616531452838988363710626354908032482922221893443836685844651", s));
+  free(s);
+
+  // zero chunks in the middle keep their padding
+  char buf[79];
+  ASSERT(20 == uint256_format_dec_into(uint256_create_from_hex("8ac7230489e80000"), buf));
+  ASSERT(0 == strcmp("10000000000000000000", buf));
+  ASSERT(19 == uint256_format_dec_into(uint256_create_from_hex("8ac7230489e7ffff"), buf));
+  ASSERT(0 == strcmp("9999999999999999999", buf));
+}
+
+void test_dec_round_trip(TestObjs *objs) {
+  (void) objs;
+
+  char buf[79];
+  uint64_t state = 0x1234123412341234ULL;
+  for (unsigned iter = 0; iter < 5000; ++iter) {
+    UInt256 orig, parsed;
+    random_uint256(&orig, &state);
+    size_t len = uint256_format_dec_into(orig, buf);
+    ASSERT(len == strlen(buf));
+    ASSERT(len == 1 || buf[0] != '0');
+    ASSERT(UINT256_OK == uint256_parse_dec_n(buf, len, &parsed));
+    ASSERT_SAME(orig, parsed);
+
+    // multiplying by ten appends a zero digit
+    if (!isZero(orig) && len < 77) {
+      UInt256 times_ten = uint256_mul(orig, uint256_create_from_u32(10));
+      char buf2[79];
+      ASSERT(len + 1 == uint256_format_dec_into(times_ten, buf2));
+      ASSERT(0 == strncmp(buf, buf2, len));
+      ASSERT('0' == buf2[len]);
+    }
+  }
+}
 
 void test_add(TestObjs *objs) {
   UInt256 result;
@@ -645,3 +912,489 @@ void test_rotate_right(TestObjs *objs) {
   result = uint256_rotate_right(objs->rot, 256);
   ASSERT_SAME(objs->rot, result);
 }
+
+void test_shl(TestObjs *objs) {
+  UInt256 result;
+
+  result = uint256_shl(objs->one, 255);
+  ASSERT_SAME(objs->msb_set, result);
+
+  // bits shifted past the top are lost
+  result = uint256_shl(objs->msb_set, 1);
+  ASSERT_SAME(objs->zero, result);
+
+  result = uint256_shl(objs->rot, 0);
+  ASSERT_SAME(objs->rot, result);
+
+  result = uint256_shl(objs->rot, 36);
+  ASSERT(0U == result.data[0]);
+  ASSERT(0x00000AB0U == result.data[1]);
+  for (unsigned i = 2; i < 8; ++i) {
+    ASSERT(0U == result.data[i]);
+  }
+
+  // shifting by 256 or more clears everything
+  result = uint256_shl(objs->max, 256);
+  ASSERT_SAME(objs->zero, result);
+  result = uint256_shl(objs->max, 511);
+  ASSERT_SAME(objs->zero, result);
+}
+
+void test_shr(TestObjs *objs) {
+  UInt256 result;
+
+  result = uint256_shr(objs->msb_set, 255);
+  ASSERT_SAME(objs->one, result);
+
+  result = uint256_shr(objs->one, 1);
+  ASSERT_SAME(objs->zero, result);
+
+  result = uint256_shr(objs->rot, 0);
+  ASSERT_SAME(objs->rot, result);
+
+  // the low word is shifted out entirely
+  result = uint256_shr(objs->rot, 36);
+  for (unsigned i = 0; i < 6; ++i) {
+    ASSERT(0U == result.data[i]);
+  }
+  ASSERT(0x0CD00000U == result.data[6]);
+  ASSERT(0U == result.data[7]);
+
+  result = uint256_shr(objs->max, 256);
+  ASSERT_SAME(objs->zero, result);
+}
+
+void test_shift_rotate_random(TestObjs *objs) {
+  (void) objs;
+
+  uint64_t state = 0x5eed5eed5eed5eedULL;
+  for (unsigned iter = 0; iter < 200; ++iter) {
+    UInt256 val;
+    random_uint256(&val, &state);
+    for (unsigned nbits = 0; nbits < 256; ++nbits) {
+      // shifting left by nbits is multiplying by 2^nbits
+      UInt256 power = uint256_shl(uint256_create_from_u32(1), nbits);
+      UInt256 left = uint256_shl(val, nbits);
+      UInt256 product = uint256_mul(val, power);
+      ASSERT_SAME(product, left);
+
+      // shifting back right recovers the bits that weren't lost
+      UInt256 back = uint256_shl(uint256_shr(left, nbits), nbits);
+      ASSERT_SAME(left, back);
+
+      // a rotation combines a left and a right shift
+      UInt256 rot = uint256_rotate_left(val, nbits);
+      UInt256 right = uint256_shr(val, 256 - nbits);
+      for (unsigned i = 0; i < 8; ++i) {
+        ASSERT(rot.data[i] == (left.data[i] | right.data[i]));
+      }
+      UInt256 undone = uint256_rotate_right(rot, nbits);
+      ASSERT_SAME(val, undone);
+    }
+  }
+}
+
+void test_cmp_eq(TestObjs *objs) {
+  ASSERT(0 == uint256_cmp(objs->zero, objs->zero));
+  ASSERT(-1 == uint256_cmp(objs->zero, objs->one));
+  ASSERT(1 == uint256_cmp(objs->max, objs->one));
+  ASSERT(1 == uint256_eq(objs->max, objs->max));
+  ASSERT(0 == uint256_eq(objs->max, objs->one));
+
+  // values that differ only in a low word, or that differ in opposite
+  // directions in a low and a high word
+  uint32_t a_words[8] = { 5, 0, 0, 0, 0, 0, 0, 7 };
+  uint32_t b_words[8] = { 6, 0, 0, 0, 0, 0, 0, 7 };
+  uint32_t c_words[8] = { 0xFFFFFFFFU, 0, 0, 0, 0, 0, 0, 8 };
+  UInt256 a = uint256_create(a_words), b = uint256_create(b_words), c = uint256_create(c_words);
+  ASSERT(-1 == uint256_cmp(a, b));
+  ASSERT(1 == uint256_cmp(b, a));
+  ASSERT(-1 == uint256_cmp(b, c));
+  ASSERT(1 == uint256_cmp(c, a));
+
+  uint64_t state = 0xc0ffee15c0ffee15ULL;
+  for (unsigned iter = 0; iter < 10000; ++iter) {
+    UInt256 left, right;
+    random_uint256(&left, &state);
+    // share the high words half of the time so lower words decide
+    if (iter & 1) {
+      right = left;
+      right.data[test_rand(&state) & 7] ^= test_rand(&state);
+    } else {
+      random_uint256(&right, &state);
+    }
+    int expected = is_less(left, right) ? -1 : (is_less(right, left) ? 1 : 0);
+    ASSERT(expected == uint256_cmp(left, right));
+    ASSERT((expected == 0) == uint256_eq(left, right));
+  }
+}
+
+void test_bitwise(TestObjs *objs) {
+  UInt256 result;
+
+  result = uint256_not(objs->zero);
+  ASSERT_SAME(objs->max, result);
+  result = uint256_and(objs->max, objs->one);
+  ASSERT_SAME(objs->one, result);
+  result = uint256_or(objs->zero, objs->one);
+  ASSERT_SAME(objs->one, result);
+  result = uint256_xor(objs->max, objs->max);
+  ASSERT_SAME(objs->zero, result);
+
+  uint64_t state = 0xb175b175b175b175ULL;
+  for (unsigned iter = 0; iter < 1000; ++iter) {
+    UInt256 left, right;
+    random_uint256(&left, &state);
+    random_uint256(&right, &state);
+    UInt256 and_val = uint256_and(left, right);
+    UInt256 or_val = uint256_or(left, right);
+    UInt256 xor_val = uint256_xor(left, right);
+    UInt256 not_val = uint256_not(left);
+    for (unsigned i = 0; i < 8; ++i) {
+      ASSERT(and_val.data[i] == (left.data[i] & right.data[i]));
+      ASSERT(or_val.data[i] == (left.data[i] | right.data[i]));
+      ASSERT(xor_val.data[i] == (left.data[i] ^ right.data[i]));
+      ASSERT(not_val.data[i] == ~left.data[i]);
+    }
+  }
+}
+
+void test_bit_counts(TestObjs *objs) {
+  ASSERT(256 == uint256_clz(objs->zero));
+  ASSERT(256 == uint256_ctz(objs->zero));
+  ASSERT(0 == uint256_popcount(objs->zero));
+  ASSERT(255 == uint256_clz(objs->one));
+  ASSERT(0 == uint256_ctz(objs->one));
+  ASSERT(1 == uint256_popcount(objs->one));
+  ASSERT(0 == uint256_clz(objs->max));
+  ASSERT(0 == uint256_ctz(objs->max));
+  ASSERT(256 == uint256_popcount(objs->max));
+
+  // a single bit at every position
+  for (unsigned bit = 0; bit < 256; ++bit) {
+    UInt256 val = uint256_shl(objs->one, bit);
+    ASSERT(255 - bit == uint256_clz(val));
+    ASSERT(bit == uint256_ctz(val));
+    ASSERT(1 == uint256_popcount(val));
+  }
+
+  uint64_t state = 0x0badc0de0badc0deULL;
+  for (unsigned iter = 0; iter < 1000; ++iter) {
+    UInt256 val;
+    random_uint256(&val, &state);
+    unsigned clz = 0, ctz = 0, pop = 0;
+    while (clz < 256 && !(val.data[(255 - clz) / 32] & (1U << ((255 - clz) % 32)))) {
+      clz++;
+    }
+    while (ctz < 256 && !(val.data[ctz / 32] & (1U << (ctz % 32)))) {
+      ctz++;
+    }
+    for (unsigned bit = 0; bit < 256; ++bit) {
+      pop += (val.data[bit / 32] >> (bit % 32)) & 1;
+    }
+    ASSERT(clz == uint256_clz(val));
+    ASSERT(ctz == uint256_ctz(val));
+    ASSERT(pop == uint256_popcount(val));
+  }
+}
+
+void test_mul(TestObjs *objs) {
+  UInt256 result;
+
+  result = uint256_mul(objs->zero, objs->max);
+  ASSERT_SAME(objs->zero, result);
+
+  result = uint256_mul(objs->one, objs->rot);
+  ASSERT_SAME(objs->rot, result);
+
+  // max * max = 2^512 - 2^257 + 1, which truncates to 1
+  result = uint256_mul(objs->max, objs->max);
+  ASSERT_SAME(objs->one, result);
+
+  // multiplying by 2^255 keeps only the lowest bit of the other operand
+  result = uint256_mul(objs->msb_set, objs->rot);
+  ASSERT_SAME(objs->msb_set, result);
+
+  // product that carries across every 64-bit word
+  UInt256 left = uint256_create_from_hex("ffffffffffffffffffffffffffffffff");
+  UInt256 right = uint256_create_from_hex("100000001");
+  result = uint256_mul(left, right);
+  UInt256 expected = uint256_create_from_hex("100000000fffffffffffffffffffffffeffffffff");
+  ASSERT_SAME(expected, result);
+}
+
+void test_mul_wide(TestObjs *objs) {
+  UInt512 result;
+
+  result = uint256_mul_wide(objs->zero, objs->max);
+  for (unsigned i = 0; i < 16; ++i) {
+    ASSERT(0U == result.data[i]);
+  }
+
+  // max * max = 2^512 - 2^257 + 1
+  result = uint256_mul_wide(objs->max, objs->max);
+  ASSERT(1U == result.data[0]);
+  for (unsigned i = 1; i < 8; ++i) {
+    ASSERT(0U == result.data[i]);
+  }
+  ASSERT(0xFFFFFFFEU == result.data[8]);
+  for (unsigned i = 9; i < 16; ++i) {
+    ASSERT(0xFFFFFFFFU == result.data[i]);
+  }
+
+  // 2^255 * 2^255 = 2^510
+  result = uint256_mul_wide(objs->msb_set, objs->msb_set);
+  for (unsigned i = 0; i < 15; ++i) {
+    ASSERT(0U == result.data[i]);
+  }
+  ASSERT(0x40000000U == result.data[15]);
+}
+
+void test_mul_random(TestObjs *objs) {
+  (void) objs;
+
+  uint64_t state = 0x0123456789abcdefULL;
+  for (unsigned iter = 0; iter < 20000; ++iter) {
+    UInt256 left, right;
+    random_uint256(&left, &state);
+    random_uint256(&right, &state);
+
+    uint32_t expected[16];
+    ref_mul_wide(left, right, expected);
+
+    UInt512 wide = uint256_mul_wide(left, right);
+    for (unsigned i = 0; i < 16; ++i) {
+      ASSERT(expected[i] == wide.data[i]);
+    }
+
+    // the truncated product is the low half of the wide product
+    UInt256 narrow = uint256_mul(left, right);
+    for (unsigned i = 0; i < 8; ++i) {
+      ASSERT(expected[i] == narrow.data[i]);
+    }
+
+    // multiplication should commute
+    UInt256 swapped = uint256_mul(right, left);
+    ASSERT_SAME(narrow, swapped);
+  }
+}
+
+void test_divmod(TestObjs *objs) {
+  UInt256 q, r;
+
+  // division by zero is reported and leaves the outputs alone
+  q = objs->one;
+  r = objs->one;
+  ASSERT(UINT256_ERR_DIV_BY_ZERO == uint256_divmod(objs->max, objs->zero, &q, &r));
+  ASSERT_SAME(objs->one, q);
+  ASSERT_SAME(objs->one, r);
+
+  ASSERT(UINT256_OK == uint256_divmod(objs->max, objs->one, &q, &r));
+  ASSERT_SAME(objs->max, q);
+  ASSERT_SAME(objs->zero, r);
+
+  ASSERT(UINT256_OK == uint256_divmod(objs->max, objs->max, &q, &r));
+  ASSERT_SAME(objs->one, q);
+  ASSERT_SAME(objs->zero, r);
+
+  // smaller dividend gives a zero quotient
+  ASSERT(UINT256_OK == uint256_divmod(objs->one, objs->max, &q, &r));
+  ASSERT_SAME(objs->zero, q);
+  ASSERT_SAME(objs->one, r);
+
+  // (2^256 - 1) / 2^255 = 1 remainder 2^255 - 1
+  ASSERT(UINT256_OK == uint256_divmod(objs->max, objs->msb_set, &q, &r));
+  ASSERT_SAME(objs->one, q);
+  ASSERT_SAME(uint256_sub(objs->msb_set, objs->one), r);
+
+  // single word divisor
+  ASSERT(UINT256_OK == uint256_divmod(uint256_create_from_hex("123456789abcdef0123456789abcdef"),
+                                      uint256_create_from_u32(10), &q, &r));
+  ASSERT_SAME(uint256_create_from_hex("1d208a5a912e31801d208a5a912e31"), q);
+  ASSERT_SAME(uint256_create_from_u32(5), r);
+
+  // multi word divisor
+  ASSERT(UINT256_OK == uint256_divmod(uint256_create_from_hex("fedcba9876543210fedcba9876543210fedcba9876543210"),
+                                      uint256_create_from_hex("123456789abcdef01"), &q, &r));
+  ASSERT_SAME(uint256_create_from_hex("e0000000000000d30b2000000000c5f4"), q);
+  ASSERT_SAME(uint256_create_from_hex("10ce91a2b3d20a01c"), r);
+
+  // only one output is needed
+  r = uint256_mod(uint256_create_from_u32(100), uint256_create_from_u32(7));
+  ASSERT_SAME(uint256_create_from_u32(2), r);
+  ASSERT(UINT256_OK == uint256_divmod(uint256_create_from_u32(100), uint256_create_from_u32(7), &q, NULL));
+  ASSERT_SAME(uint256_create_from_u32(14), q);
+}
+
+void test_divmod_random(TestObjs *objs) {
+  (void) objs;
+
+  uint64_t state = 0xd1d1d1d1cafef00dULL;
+  for (unsigned iter = 0; iter < 20000; ++iter) {
+    UInt256 num, den, q, r;
+    random_uint256(&num, &state);
+    random_uint256(&den, &state);
+    if (isZero(den)) {
+      continue;
+    }
+    ASSERT(UINT256_OK == uint256_divmod(num, den, &q, &r));
+    // remainder is smaller than the divisor
+    ASSERT(is_less(r, den));
+    // q * den + r gives back num, without overflowing 256 bits
+    UInt512 prod = uint256_mul_wide(q, den);
+    for (unsigned i = 8; i < 16; ++i) {
+      ASSERT(0U == prod.data[i]);
+    }
+    UInt256 check = uint256_add(uint256_mul(q, den), r);
+    ASSERT_SAME(num, check);
+  }
+}
+
+void test_mont(TestObjs *objs) {
+  UInt256MontCtx ctx;
+
+  ASSERT(UINT256_ERR_EVEN_MODULUS == uint256_mont_init(&ctx, uint256_create_from_u32(10)));
+
+  // p = 2^255 - 19 is prime
+  UInt256 p = uint256_sub(objs->msb_set, uint256_create_from_u32(19));
+  ASSERT(UINT256_OK == uint256_mont_init(&ctx, p));
+
+  // converting in and out of Montgomery form gives back the original value
+  UInt256 val = uint256_create_from_hex("123456789abcdef0123456789abcdef0123456789abcdef");
+  UInt256 back = uint256_mont_from(&ctx, uint256_mont_to(&ctx, val));
+  ASSERT_SAME(val, back);
+
+  // Fermat's little theorem: a^(p-1) = 1 mod p
+  UInt256 result = uint256_mont_pow(&ctx, val, uint256_sub(p, objs->one));
+  ASSERT_SAME(objs->one, result);
+
+  // a^p = a mod p, even when a needs reducing first
+  result = uint256_mont_pow(&ctx, objs->max, p);
+  ASSERT_SAME(uint256_mod(objs->max, p), result);
+
+  // x^0 = 1, 0^x = 0
+  result = uint256_mont_pow(&ctx, val, objs->zero);
+  ASSERT_SAME(objs->one, result);
+  result = uint256_mont_pow(&ctx, objs->zero, val);
+  ASSERT_SAME(objs->zero, result);
+
+  // 3^5 mod 7 = 5
+  ASSERT(UINT256_OK == uint256_mont_init(&ctx, uint256_create_from_u32(7)));
+  result = uint256_mont_pow(&ctx, uint256_create_from_u32(3), uint256_create_from_u32(5));
+  ASSERT_SAME(uint256_create_from_u32(5), result);
+
+  // the largest odd modulus works too
+  ASSERT(UINT256_OK == uint256_mont_init(&ctx, objs->max));
+  result = uint256_mont_pow(&ctx, uint256_create_from_u32(2), uint256_create_from_u32(256));
+  ASSERT_SAME(objs->one, result);
+}
+
+void test_mont_pow_random(TestObjs *objs) {
+  (void) objs;
+
+  // keep moduli below 2^128 so that a reference modular multiply can use
+  // uint256_mul and uint256_mod without overflowing
+  uint64_t state = 0x0dd0dd0dd0dd0dd0ULL;
+  for (unsigned iter = 0; iter < 200; ++iter) {
+    UInt256 mod = uint256_create_from_u32(0), base, exp;
+    for (unsigned i = 0; i < 4; ++i) {
+      mod.data[i] = test_rand(&state);
+    }
+    mod.data[0] |= 1;
+    random_uint256(&base, &state);
+    exp = uint256_create_from_u32(test_rand(&state));
+    exp.data[1] = test_rand(&state) & 0xFF;
+
+    UInt256MontCtx ctx;
+    ASSERT(UINT256_OK == uint256_mont_init(&ctx, mod));
+
+    UInt256 expected = uint256_create_from_u32(1);
+    UInt256 b = uint256_mod(base, mod);
+    for (int i = 63; i >= 0; --i) {
+      expected = uint256_mod(uint256_mul(expected, expected), mod);
+      if ((exp.data[i / 32] >> (i % 32)) & 1) {
+        expected = uint256_mod(uint256_mul(expected, b), mod);
+      }
+    }
+    if (mod.data[0] == 1 && mod.data[1] == 0 && mod.data[2] == 0 && mod.data[3] == 0) {
+      expected = uint256_create_from_u32(0);
+    }
+    UInt256 result = uint256_mont_pow(&ctx, base, exp);
+    ASSERT_SAME(expected, result);
+  }
+}
+
+// number of values used by the batch tests (not a multiple of 4, so
+// that the leftover values after the vector loop are exercised too)
+#define BATCH_TEST_SIZE 103
+
+void test_add_sub_n(TestObjs *objs) {
+  UInt256 left[BATCH_TEST_SIZE], right[BATCH_TEST_SIZE], out[BATCH_TEST_SIZE];
+  uint64_t state = 0xfeedfacecafebeefULL;
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    random_uint256(&left[i], &state);
+    random_uint256(&right[i], &state);
+  }
+  // make sure carries and borrows propagate through every word
+  left[0] = objs->max;
+  right[0] = objs->one;
+  left[1] = objs->zero;
+  right[1] = objs->one;
+
+  uint256_add_n(left, right, out, BATCH_TEST_SIZE);
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    UInt256 expected = uint256_add(left[i], right[i]);
+    ASSERT_SAME(expected, out[i]);
+  }
+  ASSERT_SAME(objs->zero, out[0]);
+
+  uint256_sub_n(left, right, out, BATCH_TEST_SIZE);
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    UInt256 expected = uint256_sub(left[i], right[i]);
+    ASSERT_SAME(expected, out[i]);
+  }
+  ASSERT_SAME(objs->max, out[1]);
+
+  // output may overlap an input
+  UInt256 copy[BATCH_TEST_SIZE];
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    copy[i] = left[i];
+  }
+  uint256_add_n(copy, right, copy, BATCH_TEST_SIZE);
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    UInt256 expected = uint256_add(left[i], right[i]);
+    ASSERT_SAME(expected, copy[i]);
+  }
+}
+
+void test_negate_rotate_n(TestObjs *objs) {
+  UInt256 vals[BATCH_TEST_SIZE], out[BATCH_TEST_SIZE];
+  uint64_t state = 0x1badb002deadbeefULL;
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    random_uint256(&vals[i], &state);
+  }
+  vals[0] = objs->zero;
+  vals[1] = objs->one;
+
+  uint256_negate_n(vals, out, BATCH_TEST_SIZE);
+  for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+    UInt256 expected = uint256_negate(vals[i]);
+    ASSERT_SAME(expected, out[i]);
+  }
+  ASSERT_SAME(objs->zero, out[0]);
+  ASSERT_SAME(objs->max, out[1]);
+
+  unsigned counts[] = { 0, 1, 4, 31, 32, 33, 64, 100, 255, 256, 300 };
+  for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    uint256_rotate_left_n(vals, counts[c], out, BATCH_TEST_SIZE);
+    for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+      UInt256 expected = uint256_rotate_left(vals[i], counts[c]);
+      ASSERT_SAME(expected, out[i]);
+    }
+    uint256_rotate_right_n(vals, counts[c], out, BATCH_TEST_SIZE);
+    for (unsigned i = 0; i < BATCH_TEST_SIZE; ++i) {
+      UInt256 expected = uint256_rotate_right(vals[i], counts[c]);
+      ASSERT_SAME(expected, out[i]);
+    }
+  }
+}
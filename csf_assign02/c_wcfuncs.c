@@ -33,6 +33,39 @@ uint32_t wc_hash(const unsigned char *w) {
   return hash_code;
 }
 
+// Constants for wc_hash_fast (the ones used by wyhash)
+#define WC_HASH_P0 0xa0761d6478bd642fULL
+#define WC_HASH_P1 0xe7037ed1a0b428dbULL
+#define WC_HASH_P2 0x8ebc6af09c88c6e3ULL
+#define WC_HASH_P3 0x589965cc75374cc3ULL
+
+// Multiply a and b to 128 bits, and fold the two halves together
+static inline uint64_t wc_hash_mix(uint64_t a, uint64_t b) {
+  __uint128_t r = (__uint128_t) a * b;
+  return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
+
+// Compute a hash code for the len bytes of w, mixing 8 bytes (read as
+// a little-endian integer) at a time, then the 0-7 bytes left over.
+uint32_t wc_hash_fast(const unsigned char *w, uint64_t len) {
+  uint64_t h = WC_HASH_P0 ^ len;
+  uint64_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t v = 0;
+    for (int k = 7; k >= 0; k--) {
+      v = (v << 8) | w[i + k];
+    }
+    h = wc_hash_mix(h ^ WC_HASH_P1, v ^ WC_HASH_P2);
+  }
+  uint64_t v = 0;
+  for (uint64_t k = len; k > i; k--) {
+    v = (v << 8) | w[k - 1];
+  }
+  h = wc_hash_mix(h ^ WC_HASH_P1, v ^ WC_HASH_P2);
+  h = wc_hash_mix(h, WC_HASH_P3);
+  return (uint32_t) (h ^ (h >> 32));
+}
+
 // Compare two strings lexicographically. Return
 //
 // - a negative value if lhs string is less than rhs string
@@ -164,6 +197,47 @@ int wc_readnext(FILE *in, unsigned char *w) {
   }
 }
 
+// Read the next word from the reader into w, exactly like wc_readnext
+// does from a FILE. Bytes are scanned straight out of the reader's
+// buffer, so there is no library call per character.
+int wc_reader_next(struct WcReader *r, unsigned char *w) {
+  int i = 0;
+  // skip whitespace, refilling the buffer as often as needed
+  for (;;) {
+    const unsigned char *p = r->buf + r->pos, *end = r->buf + r->len;
+    while (p < end && wc_isspace(*p)) {
+      p++;
+    }
+    r->pos = p - r->buf;
+    if (p < end) {
+      break;
+    }
+    if (!wc_reader_fill(r)) {
+      w[0] = '\0';
+      return 0;
+    }
+  }
+  // copy characters until whitespace or end of input; a word can
+  // continue across a refill of the buffer
+  for (;;) {
+    const unsigned char *p = r->buf + r->pos, *end = r->buf + r->len;
+    while (p < end && !wc_isspace(*p)) {
+      // make sure we keep word less than MAX_WORDLEN
+      if (i < MAX_WORDLEN) {
+        w[i] = *p;
+        i++;
+      }
+      p++;
+    }
+    r->pos = p - r->buf;
+    if (p < end || !wc_reader_fill(r)) {
+      break;
+    }
+  }
+  w[i] = '\0';
+  return 1;
+}
+
 // Convert the NUL-terminated character string in the array
 // pointed-to by w so that every letter is lower-case.
 void wc_tolower(unsigned char *w) {
@@ -216,6 +290,14 @@ void wc_trim_non_alpha(unsigned char *w) {
 // the new node should have its count value set to 0. (It is the caller's
 // job to update the count.)
 struct WordEntry *wc_find_or_insert(struct WordEntry *head, const unsigned char *s, int *inserted) {
+  return wc_find_or_insert_arena(head, s, inserted, NULL);
+}
+
+// Like wc_find_or_insert, but a new WordEntry object is allocated from
+// the arena (with malloc if arena is NULL). Returns NULL (leaving
+// *inserted unchanged) if memory can't be allocated.
+struct WordEntry *wc_find_or_insert_arena(struct WordEntry *head, const unsigned char *s, int *inserted,
+                                          struct WcEntryArena *arena) {
   struct WordEntry* curr = head;
   // loop while there are still WordEntry's in current linked list
   while (curr != NULL) {
@@ -229,7 +311,10 @@ struct WordEntry *wc_find_or_insert(struct WordEntry *head, const unsigned char
   }
 
   // if no match found, create new word entry and make it the head of the linked list
-  struct WordEntry* new = malloc(sizeof(struct WordEntry));
+  struct WordEntry* new = wc_arena_alloc(arena);
+  if (new == NULL) {
+    return NULL;
+  }
   new->count = 0;
   wc_str_copy(new->word, s);
   new->next = head;
@@ -245,10 +330,18 @@ struct WordEntry *wc_find_or_insert(struct WordEntry *head, const unsigned char
 // Returns a pointer to the WordEntry object in the appropriate linked list
 // which represents s.
 struct WordEntry *wc_dict_find_or_insert(struct WordEntry *buckets[], unsigned num_buckets, const unsigned char *s) {
+  return wc_dict_find_or_insert_arena(buckets, num_buckets, s, NULL);
+}
+
+// Like wc_dict_find_or_insert, but a new WordEntry object is allocated
+// from the arena (with malloc if arena is NULL). Returns NULL (leaving
+// the buckets unchanged) if memory can't be allocated.
+struct WordEntry *wc_dict_find_or_insert_arena(struct WordEntry *buckets[], unsigned num_buckets,
+                                               const unsigned char *s, struct WcEntryArena *arena) {
   int hash = wc_hash(s) % num_buckets;
   int inserted = 0;
   struct WordEntry *bucket = buckets[hash];
-  struct WordEntry *result = wc_find_or_insert(bucket, s, &inserted);
+  struct WordEntry *result = wc_find_or_insert_arena(bucket, s, &inserted, arena);
   // if we inserted new word entry into head of list at buckets[hash], then we need to update buckets[hash] to be the new result
   if (inserted == 1) {
     buckets[hash] = result;
@@ -264,3 +357,34 @@ void wc_free_chain(struct WordEntry *p) {
     free(temp);
   }
 }
+
+// Allocate an (uninitialized) WordEntry object from the arena, or with
+// malloc if arena is NULL.
+struct WordEntry *wc_arena_alloc(struct WcEntryArena *arena) {
+  if (arena == NULL) {
+    return malloc(sizeof(struct WordEntry));
+  }
+  // start a new block when there is none yet or the current one is full
+  if (arena->blocks == NULL || arena->used == WC_ARENA_BLOCK_ENTRIES) {
+    struct WcEntryBlock *block = malloc(sizeof(struct WcEntryBlock));
+    if (block == NULL) {
+      return NULL;
+    }
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->used = 0;
+  }
+  return &arena->blocks->entries[arena->used++];
+}
+
+// Free every WordEntry allocated from the arena, leaving it empty.
+void wc_arena_free_all(struct WcEntryArena *arena) {
+  struct WcEntryBlock *block = arena->blocks;
+  while (block != NULL) {
+    struct WcEntryBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->blocks = NULL;
+  arena->used = 0;
+}
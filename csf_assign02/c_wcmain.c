@@ -1,87 +1,459 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "wcfuncs.h"
 
-// Suggested number of buckets for the hash table
-#define HASHTABLE_SIZE 13249
+// Most threads that the -j option can ask for
+#define MAX_THREADS 256
+
+// Number of probe counts that --hash-stats reports separately
+#define HASH_STATS_BINS 16
+
+// Most words that --top and --sketch can ask for
+#define MAX_TOP_WORDS 10000000
+
+// Longest time between snapshots that --interval can ask for (a day)
+#define MAX_INTERVAL (24 * 60 * 60)
+
+// Command line options that are followed by a value
+static const char *const value_options[] = {
+  "-j", "--top", "--sketch", "--hash", "--every", "--interval", "--save",
+};
+
+// 1 if option is one of value_options
+static int takes_value(const char *option) {
+  for (size_t i = 0; i < sizeof(value_options) / sizeof(value_options[0]); i++) {
+    if (strcmp(option, value_options[i]) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Parse the value of a command line option: a number from 1 to max.
+// Returns 0 if it isn't one.
+static int parse_option_value(const char *s, long max, uint32_t *value) {
+  char *end;
+  long n = strtol(s, &end, 10);
+  if (s[0] == '\0' || *end != '\0' || n < 1 || n > max) {
+    return 0;
+  }
+  *value = (uint32_t) n;
+  return 1;
+}
+
+// Print the top words (entries[0..n-1], best first)
+static void print_top_words(const struct WcTopEntry *entries, uint32_t n, int approximate) {
+  printf("Top %u words%s:\n", n, approximate ? " (approximate)" : "");
+  for (uint32_t i = 0; i < n; i++) {
+    const struct WcTopEntry *e = &entries[i];
+    if (approximate) {
+      printf("%u. %s (%u, error <= %u)\n", i + 1, (const char *) e->word, e->count, e->error);
+    } else {
+      printf("%u. %s (%u)\n", i + 1, (const char *) e->word, e->count);
+    }
+  }
+}
+
+// Print a histogram of the number of probes it takes to find each word
+// in the dictionaries, and the average
+static void print_hash_stats(struct WcDict *words[], unsigned num_dicts) {
+  uint64_t hist[HASH_STATS_BINS] = { 0 };
+  uint64_t unique_words = 0, capacity = 0;
+  for (unsigned d = 0; d < num_dicts; d++) {
+    wc_dict_probe_histogram(words[d], hist, HASH_STATS_BINS);
+    unique_words += words[d]->size;
+    capacity += words[d]->capacity;
+  }
+  printf("Hash function: %s\n", words[0]->hash_kind == WC_HASH_FAST ? "fast" : "djb2");
+  printf("Table slots: %lu (load %.2f)\n", (unsigned long) capacity,
+         capacity > 0 ? (double) unique_words / capacity : 0.0);
+  printf("Probes to find a word:\n");
+  uint64_t probes = 0;
+  for (unsigned i = 0; i < HASH_STATS_BINS; i++) {
+    probes += (i + 1) * hist[i];
+    if (hist[i] > 0) {
+      printf("  %u%s: %lu\n", i + 1, i + 1 == HASH_STATS_BINS ? "+" : "", (unsigned long) hist[i]);
+    }
+  }
+  printf("Average probes: %.3f\n", unique_words > 0 ? (double) probes / unique_words : 0.0);
+}
+
+// Count the words of the reader approximately with a Space-Saving sketch
+// of sketch_size counters, and print the top_k of them. Memory use
+// doesn't depend on the size of the vocabulary, but the number of unique
+// words is unknown. Returns the program's exit code.
+static int count_approximate(struct WcReader *reader, uint32_t sketch_size, uint32_t top_k) {
+  struct WcSpaceSaving sketch;
+  struct WcTopK top;
+  if (!wc_space_saving_init(&sketch, sketch_size)) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    return 1;
+  }
+  if (!wc_topk_init(&top, top_k)) {
+    wc_space_saving_free(&sketch);
+    fprintf(stderr, "Error: Out of memory.\n");
+    return 1;
+  }
+
+  uint64_t total_words = 0;
+  unsigned char next_word[MAX_WORDLEN+1];
+  while (wc_reader_next(reader, next_word) != 0) {
+    total_words++;
+    wc_tolower(next_word);
+    wc_trim_non_alpha(next_word);
+    wc_space_saving_add(&sketch, next_word);
+  }
+
+  wc_space_saving_offer_top(&sketch, &top);
+  wc_topk_sort(&top);
+  printf("Total words read: %u\n", (unsigned int) total_words);
+  if (top.size > 0) {
+    printf("Most frequent word: %s (%u)\n", (const char *) top.heap[0].word, top.heap[0].count);
+  } else {
+    printf("Most frequent word:  (0)\n");
+  }
+  print_top_words(top.heap, top.size, 1);
+
+  wc_topk_free(&top);
+  wc_space_saving_free(&sketch);
+  return 0;
+}
+
+// Write the counts of the dictionaries to an index file (for --save).
+// Returns the program's exit code.
+static int save_index(const char *filename, struct WcDict *words[], unsigned num_dicts) {
+  if (!wc_index_write_dicts(filename, words, num_dicts)) {
+    fprintf(stderr, "Error: Could not write index file '%s'.\n", filename);
+    return 1;
+  }
+  return 0;
+}
+
+// Current time in seconds, for timing snapshots
+static double current_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Print the statistics so far of a streaming count. The best words come
+// from the tracker, so nothing is scanned.
+static void print_streaming_stats(uint64_t total_words, const struct WcDict *words,
+                                  const struct WcTopTracker *top, uint32_t top_k) {
+  printf("Total words read: %u\n", (unsigned int) total_words);
+  printf("Unique words read: %u\n", (unsigned int) words->size);
+  if (top->size > 0) {
+    printf("Most frequent word: %s (%u)\n", (const char *) top->entries[0].word, top->entries[0].count);
+  } else {
+    printf("Most frequent word:  (0)\n");
+  }
+  if (top_k > 0) {
+    print_top_words(top->entries, top->size, 0);
+  }
+}
+
+// Count the words of the reader as they arrive, printing a snapshot of
+// the statistics every `every` words and/or every `interval` seconds
+// (0 for never), and the final statistics at the end of the input. The
+// best top_k (at least 1) words are updated on every count, so a snapshot
+// costs O(K) however many words there are. Returns the program's exit
+// code.
+static int count_streaming(struct WcReader *reader, int hash_kind, uint32_t top_k,
+                           uint32_t every, uint32_t interval, const char *save_file) {
+  struct WcDict *words = wc_dict_create_hash(hash_kind);
+  struct WcTopTracker top;
+  if (words == NULL || !wc_top_tracker_init(&top, top_k > 0 ? top_k : 1)) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    wc_dict_destroy(words);
+    return 1;
+  }
+
+  uint64_t total_words = 0, snapshot = 0;
+  double next_snapshot_time = current_time() + interval;
+  unsigned char next_word[MAX_WORDLEN+1];
+  int result = 0;
+  while (wc_reader_next(reader, next_word) != 0) {
+    total_words++;
+    wc_tolower(next_word);
+    wc_trim_non_alpha(next_word);
+    struct WcDictSlot *slot = wc_dict_intern(words, next_word);
+    if (slot == NULL) {
+      fprintf(stderr, "Error: Out of memory.\n");
+      result = 1;
+      break;
+    }
+    slot->count++;
+    wc_top_tracker_update(&top, slot->word, slot->count);
+
+    if ((every > 0 && total_words % every == 0) ||
+        (interval > 0 && current_time() >= next_snapshot_time)) {
+      printf("Snapshot %lu:\n", (unsigned long) ++snapshot);
+      print_streaming_stats(total_words, words, &top, top_k);
+      // flush, so that a reader of the output sees it right away
+      fflush(stdout);
+      next_snapshot_time = current_time() + interval;
+    }
+  }
+
+  if (result == 0) {
+    print_streaming_stats(total_words, words, &top, top_k);
+    if (save_file != NULL) {
+      result = save_index(save_file, &words, 1);
+    }
+  }
+  wc_top_tracker_free(&top);
+  wc_dict_destroy(words);
+  return result;
+}
+
+// Count one occurrence of the already lowercased word w, adding it to
+// the dictionary if it is new
+static void count_word(struct WcDict *words, unsigned char *w) {
+  wc_trim_non_alpha(w);
+  struct WcDictSlot *slot = wc_dict_intern(words, w);
+  if (slot == NULL) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    exit(1);
+  }
+  slot->count++;
+}
+
+// Update the best word so far with the words of the dictionary: the best
+// word is the one with the most occurrences, or the lexicographically
+// smallest of those
+static void find_best_word(const struct WcDict *words, const unsigned char **best_word, uint32_t *best_word_count) {
+  for (uint64_t k = 0; k < words->capacity; k++) {
+    const struct WcDictSlot *slot = &words->slots[k];
+    if (slot->fingerprint == 0) {
+      continue;
+    }
+    // update best word if current word has more occurrences 
+    if (slot->count > *best_word_count) {
+      *best_word_count = slot->count;
+      *best_word = slot->word;
+    }
+    // if best word and curr word have same occurrences, compare them lexicographically to determine best word
+    else if (slot->count == *best_word_count) {
+      int compare = wc_str_compare(slot->word, *best_word);
+      if (compare < 0) {
+        *best_word = slot->word;
+      }
+    }
+  }
+}
 
 int main(int argc, char **argv) {
   // stats (to be printed at end)
-  uint32_t total_words = 0;
-  uint32_t unique_words = 0;
+  uint64_t total_words = 0;
+  uint64_t unique_words = 0;
   const unsigned char *best_word = (const unsigned char *) "";
   uint32_t best_word_count = 0;
 
-  // initialize hashtable of Word Entry objects
-  struct WordEntry *words[HASHTABLE_SIZE];
-  for (int x = 0; x < HASHTABLE_SIZE; x++) {
-    words[x] = NULL;
+  // options before the file name:
+  //   -j N        count with N threads
+  //   --top K     also print the K most frequent words
+  //   --sketch M  count approximately with M counters (for huge
+  //               vocabularies), printing the top K (default 1) words
+  //   --hash H    hash words with djb2 (wc_hash) or fast (wc_hash_fast)
+  //   --hash-stats  also print how many probes finding the words takes
+  //   --every N   print a snapshot of the statistics every N words
+  //   --interval T  print a snapshot of the statistics every T seconds
+  //   --save FILE also write the word counts to an index file, which
+  //               wcmerge can combine with others
+  uint32_t num_threads = 1, top_k = 0, sketch_size = 0, every = 0, interval = 0;
+  int hash_kind = WC_DEFAULT_HASH, hash_stats = 0;
+  const char *save_file = NULL;
+  int arg = 1;
+  while (arg < argc && argv[arg][0] == '-') {
+    if (strcmp(argv[arg], "--hash-stats") == 0) {
+      hash_stats = 1;
+      arg++;
+      continue;
+    }
+    // anything else that isn't an option is the file name
+    if (!takes_value(argv[arg])) {
+      break;
+    }
+    if (arg + 1 == argc) {
+      fprintf(stderr, "Error: Option '%s' needs a value.\n", argv[arg]);
+      return 1;
+    }
+    const char *value = argv[arg + 1];
+    if (strcmp(argv[arg], "-j") == 0) {
+      if (!parse_option_value(value, MAX_THREADS, &num_threads)) {
+        fprintf(stderr, "Error: Invalid number of threads '%s'.\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--top") == 0) {
+      if (!parse_option_value(value, MAX_TOP_WORDS, &top_k)) {
+        fprintf(stderr, "Error: Invalid number of top words '%s'.\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--sketch") == 0) {
+      if (!parse_option_value(value, MAX_TOP_WORDS, &sketch_size)) {
+        fprintf(stderr, "Error: Invalid sketch size '%s'.\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--every") == 0) {
+      if (!parse_option_value(value, UINT32_MAX, &every)) {
+        fprintf(stderr, "Error: Invalid number of words between snapshots '%s'.\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--interval") == 0) {
+      if (!parse_option_value(value, MAX_INTERVAL, &interval)) {
+        fprintf(stderr, "Error: Invalid number of seconds between snapshots '%s'.\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--save") == 0) {
+      save_file = value;
+    } else if (strcmp(argv[arg], "--hash") == 0) {
+      if (strcmp(value, "djb2") == 0) {
+        hash_kind = WC_HASH_DJB2;
+      } else if (strcmp(value, "fast") == 0) {
+        hash_kind = WC_HASH_FAST;
+      } else {
+        fprintf(stderr, "Error: Unknown hash function '%s'.\n", value);
+        return 1;
+      }
+    }
+    arg += 2;
+  }
+
+  if (save_file != NULL && sketch_size > 0) {
+    fprintf(stderr, "Error: --save needs exact counts, which --sketch doesn't keep.\n");
+    return 1;
+  }
+  // snapshots come from counting exactly, a word at a time on one thread
+  if ((every > 0 || interval > 0) && sketch_size > 0) {
+    fprintf(stderr, "Error: --every and --interval can't be combined with --sketch.\n");
+    return 1;
+  }
+  if ((every > 0 || interval > 0) && num_threads > 1) {
+    fprintf(stderr, "Error: --every and --interval can't be combined with -j.\n");
+    return 1;
+  }
+  if ((every > 0 || interval > 0) && hash_stats) {
+    fprintf(stderr, "Error: --every and --interval can't be combined with --hash-stats.\n");
+    return 1;
   }
 
-  FILE *file;
-  int from_stdin = 0;
+  struct WcReader *reader;
   // if text file passed in as argument, attempt to open file
-  if (argc == 2) { 
-    file = fopen(argv[1], "r");
+  // (regular files are memory-mapped rather than read with fgetc)
+  if (argc == arg + 1) { 
+    reader = wc_reader_open(argv[arg]);
     // Check if the file was successfully opened
-    if (file == NULL) {
-        fprintf(stderr, "Error: Could not open file '%s' for reading.\n", argv[1]);
+    if (reader == NULL) {
+        fprintf(stderr, "Error: Could not open file '%s' for reading.\n", argv[arg]);
         return 1; 
     }
   }
   // if no text file passed in as extra arugment, read text from stdin
   else {
-    file = stdin;
-    from_stdin = 1;
+    reader = wc_reader_open_fd(0);
+    if (reader == NULL) {
+      fprintf(stderr, "Error: Could not read from standard input.\n");
+      return 1;
+    }
   }
-  
-  // main loop: process words until we reach end of file
-  unsigned char next_word[MAX_WORDLEN+1];
-  while (wc_readnext(file, next_word) != 0) {
-    total_words++;
-    wc_tolower(next_word);
-    wc_trim_non_alpha(next_word);
-    struct WordEntry* entry = wc_dict_find_or_insert(words, HASHTABLE_SIZE, next_word);
-    // we have unique word if the count of the word is zero
-    if (entry->count == 0) {
-      unique_words++;
-    }
-    entry->count++;
-  }
-
-  // loop through entire hashtable of words to find the most common one
-  for (int k = 0; k < HASHTABLE_SIZE; k++) {
-    struct WordEntry* cur_entry = words[k];
-    while (cur_entry != NULL) {
-      // update best word if current word has more occurrences 
-      if (cur_entry->count > best_word_count) {
-        best_word_count = cur_entry->count;
-        best_word = cur_entry->word;
-      }
-      // if best word and curr word have same occurrences, compare them lexicographically to determine best word
-      else if (cur_entry->count == best_word_count) {
-        int compare = wc_str_compare(cur_entry->word, best_word);
-        if (compare < 0) {
-          best_word = cur_entry->word;
-        }
+
+  if (every > 0 || interval > 0) {
+    // snapshots need the words counted one at a time, by one thread
+    int result = count_streaming(reader, hash_kind, top_k, every, interval, save_file);
+    wc_reader_close(reader);
+    return result;
+  }
+
+  if (sketch_size > 0) {
+    // the sketch needs at least a counter for each word reported
+    if (top_k == 0) {
+      top_k = 1;
+    }
+    int result = count_approximate(reader, sketch_size > top_k ? sketch_size : top_k, top_k);
+    wc_reader_close(reader);
+    return result;
+  }
+
+  // the word counts end up in one dictionary, or one per thread with
+  // each word in just one of them
+  struct WcDict *words[MAX_THREADS];
+  unsigned num_dicts = 1;
+  int ok;
+  if (reader->mapped && num_threads > 1) {
+    // a mapped file is all in memory, so it can be split between threads
+    num_dicts = num_threads;
+    ok = wc_count_words_parallel(reader->buf + reader->pos, reader->len - reader->pos,
+                                 num_threads, hash_kind, words, &total_words);
+  } else {
+    words[0] = wc_dict_create_hash(hash_kind);
+    ok = words[0] != NULL;
+    if (ok && reader->mapped) {
+      ok = wc_count_words(words[0], reader->buf + reader->pos, reader->len - reader->pos, &total_words);
+    } else if (ok) {
+      // main loop: process words until we reach end of file
+      unsigned char next_word[MAX_WORDLEN+1];
+      while (wc_reader_next(reader, next_word) != 0) {
+        total_words++;
+        wc_tolower(next_word);
+        count_word(words[0], next_word);
       }
-      cur_entry = cur_entry->next;
     }
   }
 
+  // close file (stdin is left open)
+  wc_reader_close(reader);
+
+  if (!ok) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    if (num_dicts == 1) {
+      wc_dict_destroy(words[0]);
+    }
+    return 1;
+  }
+
+  // loop through every dictionary to find the most common word
+  for (unsigned d = 0; d < num_dicts; d++) {
+    unique_words += words[d]->size;
+    find_best_word(words[d], &best_word, &best_word_count);
+  }
+
   printf("Total words read: %u\n", (unsigned int) total_words);
   printf("Unique words read: %u\n", (unsigned int) unique_words);
   printf("Most frequent word: %s (%u)\n", (const char *) best_word, best_word_count);
 
-  // close file, if appropriate
-  if (!from_stdin) {
-    fclose(file);
+  // the top words come from a heap of K words, so finding them takes
+  // O(U log K) time for U unique words
+  int result = 0;
+  if (top_k > 0) {
+    struct WcTopK top;
+    if (!wc_topk_init(&top, top_k)) {
+      fprintf(stderr, "Error: Out of memory.\n");
+      result = 1;
+    } else {
+      for (unsigned d = 0; d < num_dicts; d++) {
+        wc_topk_offer_dict(&top, words[d]);
+      }
+      wc_topk_sort(&top);
+      print_top_words(top.heap, top.size, 0);
+      wc_topk_free(&top);
+    }
+  }
+
+  if (hash_stats) {
+    print_hash_stats(words, num_dicts);
   }
-  
-  // free all dynamically allocated data from hashtable
-  for (int x = 0; x < HASHTABLE_SIZE; x++) {
-    wc_free_chain(words[x]);
+
+  if (result == 0 && save_file != NULL) {
+    result = save_index(save_file, words, num_dicts);
   }
 
-  return 0;
+  // free the dictionaries and all of the words in them
+  for (unsigned d = 0; d < num_dicts; d++) {
+    wc_dict_destroy(words[d]);
+  }
+
+  return result;
 }
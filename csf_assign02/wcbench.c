@@ -0,0 +1,513 @@
+// wcbench: throughput of the word-count functions on a synthetic corpus.
+// Like the tests, it is linked once with c_wcfuncs.o (c_wcbench) and once
+// with asm_wcfuncs.o (asm_wcbench), so the two implementations can be
+// compared function by function.
+//
+//   wcbench [-n MB] [-v VOCAB] [-s EXPONENT] [-r REPEATS] [--seed N] [-o FILE]
+//
+// The corpus is MB megabytes of words drawn from a vocabulary of VOCAB
+// made-up words following Zipf's law (the word of rank r is picked with
+// probability proportional to 1/r^EXPONENT), some of them capitalized or
+// followed by punctuation, like real text. The same options always give
+// the same corpus. Each function is timed REPEATS times and the fastest
+// run is reported. With -o, the corpus is just written to FILE (see
+// wcbench.sh, which uses it to time the wordcount programs).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "wcfuncs.h"
+
+// Number of buckets of the chained hashtable (as in the original
+// wordcount program)
+#define BENCH_BUCKETS 13249
+
+// Largest corpus that can be asked for, in megabytes
+#define BENCH_MAX_MB 4000
+
+// Largest vocabulary that can be asked for
+#define BENCH_MAX_VOCAB 10000000
+
+// Number of bytes given to wc_tokenize at a time
+#define BENCH_WINDOW (64 * 1024)
+
+// Results of the functions that only compute a value are stored here,
+// so that the calls can't be optimized away
+static volatile uint32_t bench_sink;
+
+// The corpus, and the words in it in the two forms the functions see
+struct BenchCorpus {
+  unsigned char *text;        // the text
+  uint64_t len;               // number of bytes of text
+  FILE *file;                 // temporary file holding the text
+  unsigned char *raw;         // each word as read: length byte, bytes, NUL
+  unsigned char *words;       // each word lowercased and trimmed, the same way
+  uint64_t raw_bytes;         // sum of the lengths of the raw words
+  uint64_t word_bytes;        // sum of the lengths of the processed words
+  uint64_t num_words;         // number of words
+};
+
+// xorshift64* generator, so that a seed always gives the same corpus
+static uint64_t bench_random(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545f4914f6cdd1dULL;
+}
+
+// Uniformly distributed double in [0, 1)
+static double bench_random_unit(uint64_t *state) {
+  return (double) (bench_random(state) >> 11) / (double) (1ULL << 53);
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Generate len bytes of text from a Zipf-distributed vocabulary. Returns
+// NULL if memory can't be allocated.
+static unsigned char *bench_generate(uint64_t len, uint32_t vocab, double exponent, uint64_t seed) {
+  unsigned char *text = malloc(len);
+  unsigned char (*vocab_words)[MAX_WORDLEN + 1] = malloc(vocab * sizeof(*vocab_words));
+  double *cdf = malloc(vocab * sizeof(double));
+  if (text == NULL || vocab_words == NULL || cdf == NULL) {
+    free(text);
+    free(vocab_words);
+    free(cdf);
+    return NULL;
+  }
+  uint64_t state = seed * 0x9e3779b97f4a7c15ULL + 1;
+
+  // the more frequent words (lower ranks) tend to be shorter
+  double sum = 0;
+  for (uint32_t r = 0; r < vocab; r++) {
+    unsigned word_len = 1 + (unsigned) (bench_random(&state) % (r < 100 ? 5 : 11));
+    for (unsigned i = 0; i < word_len; i++) {
+      vocab_words[r][i] = (unsigned char) ('a' + bench_random(&state) % 26);
+    }
+    vocab_words[r][word_len] = '\0';
+    sum += 1.0 / pow(r + 1, exponent);
+    cdf[r] = sum;
+  }
+
+  static const char punctuation[] = ",.;:!?\"')";
+  uint64_t pos = 0, words_on_line = 0;
+  while (pos < len) {
+    // pick a rank: binary search for the first cdf entry above u
+    double u = bench_random_unit(&state) * sum;
+    uint32_t lo = 0, hi = vocab - 1;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (cdf[mid] > u) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    unsigned char token[MAX_WORDLEN + 3];
+    uint64_t n = strlen((const char *) vocab_words[lo]);
+    memcpy(token, vocab_words[lo], n);
+    uint64_t r = bench_random(&state) % 100;
+    if (r < 5) {
+      token[0] = (unsigned char) (token[0] - 'a' + 'A');
+    } else if (r < 13) {
+      token[n++] = (unsigned char) punctuation[bench_random(&state) % (sizeof(punctuation) - 1)];
+    }
+    // about a dozen words to a line
+    token[n++] = ++words_on_line % 12 == 0 ? '\n' : ' ';
+    if (n > len - pos) {
+      n = len - pos;
+    }
+    memcpy(text + pos, token, n);
+    pos += n;
+  }
+  free(vocab_words);
+  free(cdf);
+  return text;
+}
+
+// Set up everything but the text of the corpus. Returns 0 if memory
+// can't be allocated or the temporary file can't be written.
+static int bench_prepare(struct BenchCorpus *c) {
+  c->file = tmpfile();
+  if (c->file == NULL || fwrite(c->text, 1, c->len, c->file) != c->len || fflush(c->file) != 0) {
+    return 0;
+  }
+  // a word of n bytes takes n + 2 bytes in each list, and (but for the
+  // last word) n + 1 bytes of text with its separator, where n >= 1
+  c->raw = malloc(c->len / 2 * 3 + 4);
+  c->words = malloc(c->len / 2 * 3 + 4);
+  if (c->raw == NULL || c->words == NULL) {
+    return 0;
+  }
+  rewind(c->file);
+  unsigned char w[MAX_WORDLEN + 1];
+  unsigned char *raw = c->raw, *words = c->words;
+  c->raw_bytes = c->word_bytes = c->num_words = 0;
+  while (wc_readnext(c->file, w)) {
+    uint64_t n = strlen((const char *) w);
+    raw[0] = (unsigned char) n;
+    memcpy(raw + 1, w, n + 1);
+    raw += n + 2;
+    c->raw_bytes += n;
+    wc_tolower(w);
+    wc_trim_non_alpha(w);
+    n = strlen((const char *) w);
+    words[0] = (unsigned char) n;
+    memcpy(words + 1, w, n + 1);
+    words += n + 2;
+    c->word_bytes += n;
+    c->num_words++;
+  }
+  return 1;
+}
+
+// The benchmarks. Each one processes the whole corpus (or all of its
+// words) once, timing just that, and stores the number of bytes it read
+// and words it handled. They return the time taken in seconds, or a
+// negative value if memory can't be allocated.
+
+static double bench_readnext(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  unsigned char w[MAX_WORDLEN + 1];
+  uint64_t n = 0;
+  rewind(c->file);
+  double start = bench_now();
+  while (wc_readnext(c->file, w)) {
+    n++;
+  }
+  double elapsed = bench_now() - start;
+  *bytes = c->len;
+  *words = n;
+  return elapsed;
+}
+
+static double bench_reader_next(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  unsigned char w[MAX_WORDLEN + 1];
+  uint64_t n = 0;
+  lseek(fileno(c->file), 0, SEEK_SET);
+  double start = bench_now();
+  struct WcReader *r = wc_reader_open_fd(fileno(c->file));
+  if (r == NULL) {
+    return -1;
+  }
+  while (wc_reader_next(r, w)) {
+    n++;
+  }
+  wc_reader_close(r);
+  double elapsed = bench_now() - start;
+  *bytes = c->len;
+  *words = n;
+  return elapsed;
+}
+
+static double bench_tokenize(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  unsigned char *lower = malloc(BENCH_WINDOW);
+  struct WcSpan *spans = malloc(BENCH_WINDOW / 2 * sizeof(struct WcSpan));
+  if (lower == NULL || spans == NULL) {
+    free(lower);
+    free(spans);
+    return -1;
+  }
+  uint64_t n = 0, pos = 0;
+  double start = bench_now();
+  while (pos < c->len) {
+    uint64_t window = c->len - pos < BENCH_WINDOW ? c->len - pos : BENCH_WINDOW;
+    uint64_t consumed;
+    n += wc_tokenize(c->text + pos, window, pos + window == c->len, lower, spans, BENCH_WINDOW / 2, &consumed);
+    // (no word of the corpus is anywhere near a window long)
+    pos += consumed;
+  }
+  double elapsed = bench_now() - start;
+  free(lower);
+  free(spans);
+  *bytes = c->len;
+  *words = n;
+  return elapsed;
+}
+
+static double bench_tolower_trim(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  unsigned char w[MAX_WORDLEN + 1];
+  const unsigned char *p = c->raw;
+  double start = bench_now();
+  for (uint64_t i = 0; i < c->num_words; i++) {
+    memcpy(w, p + 1, p[0] + 1);
+    wc_tolower(w);
+    wc_trim_non_alpha(w);
+    p += p[0] + 2;
+  }
+  double elapsed = bench_now() - start;
+  *bytes = c->raw_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+static double bench_hash(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  const unsigned char *p = c->words;
+  uint32_t sum = 0;
+  double start = bench_now();
+  for (uint64_t i = 0; i < c->num_words; i++) {
+    sum += wc_hash(p + 1);
+    p += p[0] + 2;
+  }
+  double elapsed = bench_now() - start;
+  bench_sink = sum;
+  *bytes = c->word_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+static double bench_hash_fast(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  const unsigned char *p = c->words;
+  uint32_t sum = 0;
+  double start = bench_now();
+  for (uint64_t i = 0; i < c->num_words; i++) {
+    sum += wc_hash_fast(p + 1, p[0]);
+    p += p[0] + 2;
+  }
+  double elapsed = bench_now() - start;
+  bench_sink = sum;
+  *bytes = c->word_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+static double bench_str_compare(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  // compare each word with the one before it
+  const unsigned char *prev = c->words + 1, *p = c->words;
+  uint32_t sum = 0;
+  double start = bench_now();
+  for (uint64_t i = 0; i < c->num_words; i++) {
+    sum += (uint32_t) wc_str_compare(prev, p + 1);
+    prev = p + 1;
+    p += p[0] + 2;
+  }
+  double elapsed = bench_now() - start;
+  bench_sink = sum;
+  *bytes = c->word_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+// wc_dict_find_or_insert with each entry malloc'ed (arena NULL) or taken
+// from an arena
+static double bench_chains(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words, int use_arena) {
+  struct WordEntry **buckets = calloc(BENCH_BUCKETS, sizeof(struct WordEntry *));
+  struct WcEntryArena arena = { NULL, 0 };
+  if (buckets == NULL) {
+    return -1;
+  }
+  const unsigned char *p = c->words;
+  double start = bench_now();
+  uint64_t i;
+  for (i = 0; i < c->num_words; i++) {
+    struct WordEntry *e = use_arena ? wc_dict_find_or_insert_arena(buckets, BENCH_BUCKETS, p + 1, &arena)
+                                    : wc_dict_find_or_insert(buckets, BENCH_BUCKETS, p + 1);
+    if (e == NULL) {
+      break;
+    }
+    e->count++;
+    p += p[0] + 2;
+  }
+  // out of memory part way: still free what was allocated
+  double elapsed = i < c->num_words ? -1 : bench_now() - start;
+  if (use_arena) {
+    wc_arena_free_all(&arena);
+  } else {
+    for (unsigned b = 0; b < BENCH_BUCKETS; b++) {
+      wc_free_chain(buckets[b]);
+    }
+  }
+  free(buckets);
+  *bytes = c->word_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+static double bench_find_or_insert(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  return bench_chains(c, bytes, words, 0);
+}
+
+static double bench_find_or_insert_arena(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  return bench_chains(c, bytes, words, 1);
+}
+
+static double bench_intern(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words, int hash_kind) {
+  struct WcDict *d = wc_dict_create_hash(hash_kind);
+  if (d == NULL) {
+    return -1;
+  }
+  const unsigned char *p = c->words;
+  double start = bench_now();
+  for (uint64_t i = 0; i < c->num_words; i++) {
+    struct WcDictSlot *slot = wc_dict_intern(d, p + 1);
+    if (slot == NULL) {
+      wc_dict_destroy(d);
+      return -1;
+    }
+    slot->count++;
+    p += p[0] + 2;
+  }
+  double elapsed = bench_now() - start;
+  wc_dict_destroy(d);
+  *bytes = c->word_bytes;
+  *words = c->num_words;
+  return elapsed;
+}
+
+static double bench_intern_djb2(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  return bench_intern(c, bytes, words, WC_HASH_DJB2);
+}
+
+static double bench_intern_fast(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  return bench_intern(c, bytes, words, WC_HASH_FAST);
+}
+
+static double bench_count_words(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words) {
+  struct WcDict *d = wc_dict_create();
+  if (d == NULL) {
+    return -1;
+  }
+  double start = bench_now();
+  int ok = wc_count_words(d, c->text, c->len, words);
+  double elapsed = bench_now() - start;
+  wc_dict_destroy(d);
+  *bytes = c->len;
+  return ok ? elapsed : -1;
+}
+
+struct BenchCase {
+  const char *name;
+  double (*run)(struct BenchCorpus *c, uint64_t *bytes, uint64_t *words);
+};
+
+static const struct BenchCase bench_cases[] = {
+  { "wc_readnext", bench_readnext },
+  { "wc_reader_next", bench_reader_next },
+  { "wc_tokenize", bench_tokenize },
+  { "wc_tolower+wc_trim_non_alpha", bench_tolower_trim },
+  { "wc_hash", bench_hash },
+  { "wc_hash_fast", bench_hash_fast },
+  { "wc_str_compare", bench_str_compare },
+  { "wc_dict_find_or_insert", bench_find_or_insert },
+  { "wc_dict_find_or_insert_arena", bench_find_or_insert_arena },
+  { "wc_dict_intern (djb2)", bench_intern_djb2 },
+  { "wc_dict_intern (fast)", bench_intern_fast },
+  { "wc_count_words", bench_count_words },
+};
+
+// Parse a number option in [min, max]. Returns 0 if it isn't one.
+static int parse_number(const char *s, double min, double max, double *value) {
+  char *end;
+  double v = strtod(s, &end);
+  if (s[0] == '\0' || *end != '\0' || !(v >= min && v <= max)) {
+    return 0;
+  }
+  *value = v;
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  double mb = 32, vocab = 50000, exponent = 1.0, repeats = 3, seed = 1;
+  const char *output = NULL;
+  for (int arg = 1; arg < argc; arg += 2) {
+    const char *opt = argv[arg];
+    const char *value = arg + 1 < argc ? argv[arg + 1] : "";
+    int ok;
+    if (strcmp(opt, "-n") == 0) {
+      ok = parse_number(value, 0.001, BENCH_MAX_MB, &mb);
+    } else if (strcmp(opt, "-v") == 0) {
+      ok = parse_number(value, 1, BENCH_MAX_VOCAB, &vocab);
+    } else if (strcmp(opt, "-s") == 0) {
+      ok = parse_number(value, 0, 10, &exponent);
+    } else if (strcmp(opt, "-r") == 0) {
+      ok = parse_number(value, 1, 1000, &repeats);
+    } else if (strcmp(opt, "--seed") == 0) {
+      ok = parse_number(value, 0, 1e15, &seed);
+    } else if (strcmp(opt, "-o") == 0) {
+      output = value;
+      ok = value[0] != '\0';
+    } else {
+      ok = 0;
+    }
+    if (!ok) {
+      fprintf(stderr, "Usage: %s [-n MB] [-v VOCAB] [-s EXPONENT] [-r REPEATS] [--seed N] [-o FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  struct BenchCorpus corpus;
+  memset(&corpus, 0, sizeof(corpus));
+  corpus.len = (uint64_t) (mb * 1e6);
+  corpus.text = bench_generate(corpus.len, (uint32_t) vocab, exponent, (uint64_t) seed);
+  if (corpus.text == NULL) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    return 1;
+  }
+
+  if (output != NULL) {
+    FILE *out = fopen(output, "wb");
+    int ok = out != NULL && fwrite(corpus.text, 1, corpus.len, out) == corpus.len;
+    if (out != NULL && fclose(out) != 0) {
+      ok = 0;
+    }
+    free(corpus.text);
+    if (!ok) {
+      fprintf(stderr, "Error: Could not write '%s'.\n", output);
+      return 1;
+    }
+    return 0;
+  }
+
+  int result = 0;
+  if (!bench_prepare(&corpus)) {
+    fprintf(stderr, "Error: Could not set up the corpus.\n");
+    result = 1;
+  } else {
+    printf("Corpus: %.1f MB, %lu words, vocabulary %u, Zipf exponent %.2f\n",
+           corpus.len / 1e6, (unsigned long) corpus.num_words, (unsigned) vocab, exponent);
+    printf("(MB/s counts the bytes each function reads: the whole text, or just the words)\n");
+    printf("%-30s %9s %9s %9s\n", "function", "time (s)", "MB/s", "Mwords/s");
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+      double best = -1;
+      uint64_t bytes = 0, words = 0;
+      for (int r = 0; r < (int) repeats; r++) {
+        double t = bench_cases[i].run(&corpus, &bytes, &words);
+        if (t < 0) {
+          best = -1;
+          break;
+        }
+        if (best < 0 || t < best) {
+          best = t;
+        }
+      }
+      if (best < 0) {
+        fprintf(stderr, "Error: %s failed (out of memory).\n", bench_cases[i].name);
+        result = 1;
+        continue;
+      }
+      // the clock's resolution is far below anything measured here, but
+      // avoid dividing by 0 all the same
+      if (best < 1e-9) {
+        best = 1e-9;
+      }
+      printf("%-30s %9.3f %9.1f %9.2f\n", bench_cases[i].name, best, bytes / best / 1e6, words / best / 1e6);
+      fflush(stdout);
+    }
+  }
+
+  if (corpus.file != NULL) {
+    fclose(corpus.file);
+  }
+  free(corpus.raw);
+  free(corpus.words);
+  free(corpus.text);
+  return result;
+}
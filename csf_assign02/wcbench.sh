@@ -0,0 +1,39 @@
+#!/bin/sh
+# Compare the C and assembly word-count implementations (run by "make
+# bench"): first each function, with c_wcbench and asm_wcbench, then the
+# wordcount programs as a whole on the same corpus.
+#
+#   wcbench.sh [MB [VOCAB [EXPONENT]]]
+
+MB=${1:-32}
+VOCAB=${2:-50000}
+ZIPF=${3:-1.0}
+
+corpus=$(mktemp /tmp/wcbench.XXXXXX) || exit 1
+trap 'rm -f "$corpus"' EXIT
+
+echo "== C functions (c_wcbench) =="
+./c_wcbench -n "$MB" -v "$VOCAB" -s "$ZIPF" || exit 1
+echo
+echo "== assembly functions (asm_wcbench) =="
+./asm_wcbench -n "$MB" -v "$VOCAB" -s "$ZIPF" || exit 1
+echo
+
+echo "== programs =="
+./c_wcbench -n "$MB" -v "$VOCAB" -s "$ZIPF" -o "$corpus" || exit 1
+bytes=$(wc -c < "$corpus")
+printf '%-30s %9s %9s %9s\n' program "time (s)" MB/s Mwords/s
+for prog in c_wordcount casm_wordcount asm_wordcount "c_wordcount -j 4"; do
+  start=$(date +%s.%N)
+  words=$(./$prog "$corpus" | sed -n 's/^Total words read: //p')
+  end=$(date +%s.%N)
+  if [ -z "$words" ]; then
+    echo "$prog failed" >&2
+    exit 1
+  fi
+  awk -v prog="$prog" -v start="$start" -v end="$end" -v bytes="$bytes" -v words="$words" 'BEGIN {
+    t = end - start
+    if (t <= 0) t = 1e-9
+    printf "%-30s %9.3f %9.1f %9.2f\n", prog, t, bytes / t / 1e6, words / t / 1e6
+  }'
+done
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Check how c_wordcount handles its command line (run by "make check"):
+# each case runs it and compares the exit status and the first line of
+# output, or of the error message if it fails.
+
+failed=0
+
+# expect STATUS FIRST_LINE INPUT ARGS...: run c_wordcount ARGS with INPUT
+# as stdin
+expect() {
+  status=$1 first=$2 input=$3
+  shift 3
+  output=$(printf '%s' "$input" | ./c_wordcount "$@" 2>&1)
+  actual=$?
+  line=$(printf '%s\n' "$output" | head -n 1)
+  if [ "$actual" -ne "$status" ] || [ "$line" != "$first" ]; then
+    echo "FAILED: c_wordcount $* (status $actual: $line)"
+    failed=1
+  fi
+}
+
+# --hash-stats takes no value, so it works last or on its own
+expect 0 "Total words read: 2" "a b" --hash-stats
+expect 0 "Total words read: 3" "a b a" --top 2 --hash-stats
+expect 0 "Total words read: 3" "a b a" --hash-stats --top 2
+# an option missing its value is an error, not the file name
+expect 1 "Error: Option '--top' needs a value." "a" --top
+expect 1 "Error: Option '-j' needs a value." "a" --hash-stats -j
+# streaming snapshots can't honor options for the other counting modes
+expect 1 "Error: --every and --interval can't be combined with --sketch." "a" --every 2 --sketch 5 -j 4
+expect 1 "Error: --every and --interval can't be combined with -j." "a" --interval 1 -j 4
+expect 1 "Error: --every and --interval can't be combined with --hash-stats." "a" --every 2 --hash-stats
+expect 0 "Snapshot 1:" "a b a" --every 2 --top 2 -j 1
+
+if [ "$failed" -eq 0 ]; then
+  echo "All command line checks passed!"
+fi
+exit $failed
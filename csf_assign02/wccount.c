@@ -0,0 +1,191 @@
+// Counting all of the words of an in-memory buffer into WcDicts, with
+// one thread or several.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wcfuncs.h"
+
+// Number of bytes tokenized per call to wc_tokenize, and the most words
+// found per call
+#define WC_COUNT_WINDOW (64 * 1024)
+#define WC_COUNT_MAX_SPANS (WC_COUNT_WINDOW / 2)
+
+// Count one occurrence of the lowercased word text[0..len-1] (only the
+// first MAX_WORDLEN bytes are kept, like wc_readnext does) with its
+// trailing non-letters removed. Returns 0 if memory can't be allocated.
+static int wc_count_span(struct WcDict *d, const unsigned char *text, uint64_t len) {
+  unsigned char w[MAX_WORDLEN + 1];
+  if (len > MAX_WORDLEN) {
+    len = MAX_WORDLEN;
+  }
+  memcpy(w, text, len);
+  w[len] = '\0';
+  wc_trim_non_alpha(w);
+  struct WcDictSlot *slot = wc_dict_intern(d, w);
+  if (slot == NULL) {
+    return 0;
+  }
+  slot->count++;
+  return 1;
+}
+
+int wc_count_words(struct WcDict *d, const unsigned char *buf, uint64_t len, uint64_t *total_words) {
+  unsigned char *lower = malloc(WC_COUNT_WINDOW);
+  struct WcSpan *spans = malloc(WC_COUNT_MAX_SPANS * sizeof(struct WcSpan));
+  int ok = lower != NULL && spans != NULL;
+  uint64_t pos = 0, total = 0;
+  while (ok && pos < len) {
+    uint64_t window = len - pos;
+    int at_end = 1;
+    if (window > WC_COUNT_WINDOW) {
+      window = WC_COUNT_WINDOW;
+      at_end = 0;
+    }
+    uint64_t consumed;
+    uint64_t n = wc_tokenize(buf + pos, window, at_end, lower, spans, WC_COUNT_MAX_SPANS, &consumed);
+    for (uint64_t k = 0; ok && k < n; k++) {
+      ok = wc_count_span(d, lower + spans[k].offset, spans[k].len);
+    }
+    total += n;
+    if (consumed == 0) {
+      // a single word fills the whole window: count its beginning and
+      // skip the rest of it
+      ok = ok && wc_count_span(d, lower, window);
+      total++;
+      consumed = window;
+      while (pos + consumed < len && !wc_isspace(buf[pos + consumed])) {
+        consumed++;
+      }
+    }
+    pos += consumed;
+  }
+  free(lower);
+  free(spans);
+  *total_words = total;
+  return ok;
+}
+
+// Work done by one thread of wc_count_words_parallel: first counting
+// buf[start..end-1] into local, then merging the words of partition part
+// of every thread's local dictionary into merged.
+struct WcCountTask {
+  const unsigned char *buf;
+  uint64_t start, end;
+  struct WcDict *local;
+  uint64_t total_words;
+  unsigned part, nparts;
+  struct WcCountTask *tasks;  // all of the tasks, to find the other dictionaries
+  struct WcDict *merged;
+  int ok;
+};
+
+// Partition that a word with the given fingerprint is merged into. The
+// high bits are used, since the low ones pick the slot in the table.
+static inline unsigned wc_count_partition(uint32_t fingerprint, unsigned nparts) {
+  return (unsigned) (((uint64_t) (fingerprint & 0x7fffffffu) * nparts) >> 31);
+}
+
+static void *wc_count_thread(void *arg) {
+  struct WcCountTask *task = arg;
+  task->ok = wc_count_words(task->local, task->buf + task->start, task->end - task->start,
+                            &task->total_words);
+  return NULL;
+}
+
+static void *wc_merge_thread(void *arg) {
+  struct WcCountTask *task = arg;
+  task->ok = 1;
+  for (unsigned t = 0; task->ok && t < task->nparts; t++) {
+    const struct WcDict *local = task->tasks[t].local;
+    for (uint64_t i = 0; i < local->capacity; i++) {
+      const struct WcDictSlot *from = &local->slots[i];
+      if (from->fingerprint == 0 || wc_count_partition(from->fingerprint, task->nparts) != task->part) {
+        continue;
+      }
+      // the fingerprint has the bits of the hash code that are used
+      struct WcDictSlot *to = wc_dict_intern_hash(task->merged, from->word, from->fingerprint);
+      if (to == NULL) {
+        task->ok = 0;
+        break;
+      }
+      to->count += from->count;
+    }
+  }
+  return NULL;
+}
+
+// Run fn on every task, each in its own thread. Returns 0 if any thread
+// can't be created (the tasks that could be run are still waited for).
+static int wc_count_run(struct WcCountTask *tasks, unsigned nthreads, void *(*fn)(void *)) {
+  pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+  if (threads == NULL) {
+    return 0;
+  }
+  unsigned started = 0;
+  while (started < nthreads && pthread_create(&threads[started], NULL, fn, &tasks[started]) == 0) {
+    started++;
+  }
+  for (unsigned t = 0; t < started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  free(threads);
+  return started == nthreads;
+}
+
+int wc_count_words_parallel(const unsigned char *buf, uint64_t len, unsigned nthreads, int hash_kind,
+                            struct WcDict *parts[], uint64_t *total_words) {
+  struct WcCountTask *tasks = calloc(nthreads, sizeof(struct WcCountTask));
+  if (tasks == NULL) {
+    return 0;
+  }
+  int ok = 1;
+  uint64_t start = 0;
+  for (unsigned t = 0; t < nthreads; t++) {
+    // end each chunk at whitespace, so that no word is split between
+    // two threads
+    uint64_t end = t + 1 == nthreads ? len : len / nthreads * (t + 1);
+    if (end < start) {
+      end = start;
+    }
+    while (end < len && !wc_isspace(buf[end])) {
+      end++;
+    }
+    tasks[t].buf = buf;
+    tasks[t].start = start;
+    tasks[t].end = end;
+    tasks[t].part = t;
+    tasks[t].nparts = nthreads;
+    tasks[t].tasks = tasks;
+    tasks[t].local = wc_dict_create_hash(hash_kind);
+    tasks[t].merged = wc_dict_create_hash(hash_kind);
+    ok = ok && tasks[t].local != NULL && tasks[t].merged != NULL;
+    start = end;
+  }
+
+  // count each chunk, then merge each partition of the words
+  ok = ok && wc_count_run(tasks, nthreads, wc_count_thread);
+  for (unsigned t = 0; ok && t < nthreads; t++) {
+    ok = tasks[t].ok;
+  }
+  ok = ok && wc_count_run(tasks, nthreads, wc_merge_thread);
+
+  uint64_t total = 0;
+  for (unsigned t = 0; t < nthreads; t++) {
+    ok = ok && tasks[t].ok;
+    total += tasks[t].total_words;
+    wc_dict_destroy(tasks[t].local);
+    parts[t] = tasks[t].merged;
+  }
+  free(tasks);
+  if (!ok) {
+    for (unsigned t = 0; t < nthreads; t++) {
+      wc_dict_destroy(parts[t]);
+      parts[t] = NULL;
+    }
+    return 0;
+  }
+  *total_words = total;
+  return 1;
+}
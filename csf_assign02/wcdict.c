@@ -0,0 +1,165 @@
+// Open-addressing dictionary of word counts (struct WcDict). Hashing and
+// comparing words is done with wc_hash (or wc_hash_fast) and
+// wc_str_compare, so the C and assembly builds each use their own
+// versions of those.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wcfuncs.h"
+
+// Number of slots in a new dictionary
+#define WC_DICT_INITIAL_CAPACITY 1024
+
+// Size of the data of each arena block
+#define WC_DICT_CHUNK_SIZE (64 * 1024)
+
+// Fingerprint of a word with the given hash code (never 0)
+static inline uint32_t wc_dict_fingerprint(uint32_t hash) {
+  return hash | 0x80000000u;
+}
+
+// Copy the len bytes of w plus a NUL terminator into the arena
+static const unsigned char *wc_dict_copy_word(struct WcDict *d, const unsigned char *w, uint64_t len) {
+  struct WcDictChunk *chunk = d->arena;
+  if (chunk == NULL || chunk->size - chunk->used < len + 1) {
+    uint64_t size = len + 1 > WC_DICT_CHUNK_SIZE ? len + 1 : WC_DICT_CHUNK_SIZE;
+    chunk = malloc(sizeof(struct WcDictChunk) + size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = d->arena;
+    chunk->used = 0;
+    chunk->size = size;
+    d->arena = chunk;
+  }
+  unsigned char *copy = chunk->data + chunk->used;
+  memcpy(copy, w, len + 1);
+  chunk->used += len + 1;
+  return copy;
+}
+
+// Move every slot into a table twice the size. Returns 0 if memory can't
+// be allocated (the dictionary is left as it was).
+static int wc_dict_grow(struct WcDict *d) {
+  uint64_t capacity = d->capacity * 2;
+  struct WcDictSlot *slots = calloc(capacity, sizeof(struct WcDictSlot));
+  if (slots == NULL) {
+    return 0;
+  }
+  uint64_t mask = capacity - 1;
+  for (uint64_t i = 0; i < d->capacity; i++) {
+    struct WcDictSlot *old = &d->slots[i];
+    if (old->fingerprint == 0) {
+      continue;
+    }
+    // the fingerprint has every bit of the hash used for indexing
+    uint64_t j = old->fingerprint & mask;
+    while (slots[j].fingerprint != 0) {
+      j = (j + 1) & mask;
+    }
+    slots[j] = *old;
+  }
+  free(d->slots);
+  d->slots = slots;
+  d->capacity = capacity;
+  return 1;
+}
+
+struct WcDict *wc_dict_create(void) {
+  return wc_dict_create_hash(WC_DEFAULT_HASH);
+}
+
+struct WcDict *wc_dict_create_hash(int hash_kind) {
+  struct WcDict *d = calloc(1, sizeof(struct WcDict));
+  if (d == NULL) {
+    return NULL;
+  }
+  d->slots = calloc(WC_DICT_INITIAL_CAPACITY, sizeof(struct WcDictSlot));
+  if (d->slots == NULL) {
+    free(d);
+    return NULL;
+  }
+  d->capacity = WC_DICT_INITIAL_CAPACITY;
+  d->hash_kind = hash_kind;
+  return d;
+}
+
+uint32_t wc_dict_hash(const struct WcDict *d, const unsigned char *w, uint64_t len) {
+  return d->hash_kind == WC_HASH_FAST ? wc_hash_fast(w, len) : wc_hash(w);
+}
+
+// Find the slot holding w, or the empty slot where it belongs
+static struct WcDictSlot *wc_dict_probe(struct WcDict *d, const unsigned char *w, uint32_t fingerprint) {
+  uint64_t mask = d->capacity - 1;
+  uint64_t i = fingerprint & mask;
+  for (;;) {
+    struct WcDictSlot *slot = &d->slots[i];
+    if (slot->fingerprint == 0 ||
+        (slot->fingerprint == fingerprint && wc_str_compare(slot->word, w) == 0)) {
+      return slot;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+struct WcDictSlot *wc_dict_intern(struct WcDict *d, const unsigned char *w) {
+  return wc_dict_intern_hash(d, w, wc_dict_hash(d, w, strlen((const char *) w)));
+}
+
+struct WcDictSlot *wc_dict_intern_hash(struct WcDict *d, const unsigned char *w, uint32_t hash) {
+  uint32_t fingerprint = wc_dict_fingerprint(hash);
+  struct WcDictSlot *slot = wc_dict_probe(d, w, fingerprint);
+  if (slot->fingerprint != 0) {
+    return slot;
+  }
+  // keep the table at most 3/4 full, so probe sequences stay short
+  if ((d->size + 1) * 4 > d->capacity * 3) {
+    if (!wc_dict_grow(d)) {
+      return NULL;
+    }
+    slot = wc_dict_probe(d, w, fingerprint);
+  }
+  const unsigned char *copy = wc_dict_copy_word(d, w, strlen((const char *) w));
+  if (copy == NULL) {
+    return NULL;
+  }
+  slot->fingerprint = fingerprint;
+  slot->count = 0;
+  slot->word = copy;
+  d->size++;
+  return slot;
+}
+
+struct WcDictSlot *wc_dict_find(struct WcDict *d, const unsigned char *w) {
+  uint32_t hash = wc_dict_hash(d, w, strlen((const char *) w));
+  struct WcDictSlot *slot = wc_dict_probe(d, w, wc_dict_fingerprint(hash));
+  return slot->fingerprint != 0 ? slot : NULL;
+}
+
+void wc_dict_probe_histogram(const struct WcDict *d, uint64_t hist[], unsigned num_bins) {
+  uint64_t mask = d->capacity - 1;
+  for (uint64_t i = 0; i < d->capacity; i++) {
+    uint32_t fingerprint = d->slots[i].fingerprint;
+    if (fingerprint == 0) {
+      continue;
+    }
+    // a word is found on the probe after its distance from its home slot
+    uint64_t distance = (i - fingerprint) & mask;
+    hist[distance < num_bins ? distance : num_bins - 1]++;
+  }
+}
+
+void wc_dict_destroy(struct WcDict *d) {
+  if (d == NULL) {
+    return;
+  }
+  struct WcDictChunk *chunk = d->arena;
+  while (chunk != NULL) {
+    struct WcDictChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(d->slots);
+  free(d);
+}
@@ -6,12 +6,215 @@
 
 #define MAX_WORDLEN 63
 
+// Hash functions a WcDict can use: wc_hash (djb2, one byte at a time),
+// or wc_hash_fast (8 bytes at a time). WC_DEFAULT_HASH, which can be set
+// at compile time, is the one used by wc_dict_create.
+#define WC_HASH_DJB2 0
+#define WC_HASH_FAST 1
+#ifndef WC_DEFAULT_HASH
+#define WC_DEFAULT_HASH WC_HASH_DJB2
+#endif
+
 struct WordEntry {
   unsigned char word[MAX_WORDLEN + 1];
   uint32_t count; // number of occurrences of this word
   struct WordEntry *next;
 };
 
+// Number of WordEntry objects in each block of a WcEntryArena
+#define WC_ARENA_BLOCK_ENTRIES 1024
+
+// A block of WordEntry objects allocated by a WcEntryArena
+struct WcEntryBlock {
+  struct WcEntryBlock *next;  // previously allocated block
+  struct WordEntry entries[WC_ARENA_BLOCK_ENTRIES];
+};
+
+// Bump allocator for WordEntry objects: entries are handed out in order
+// from the current block, and a new block is allocated when it is used
+// up. Every entry is freed at once by wc_arena_free_all. An arena whose
+// fields are all 0 is empty and ready to use.
+//
+// The assembly implementation depends on the offsets of blocks and used.
+struct WcEntryArena {
+  struct WcEntryBlock *blocks;  // current block, NULL if none yet
+  uint64_t used;                // number of entries of the current block in use
+};
+
+// A word and its count, as reported by a WcTopK
+struct WcTopEntry {
+  const unsigned char *word;
+  uint32_t count;             // number of occurrences
+  uint32_t error;             // most that count may be too high by (0 if exact)
+};
+
+// The best K words offered so far. One word is better than another if
+// it has more occurrences, or the same number and is lexicographically
+// smaller (the rule for the most frequent word). The entries are a
+// min-heap whose root is the worst of them, so offering a word costs
+// O(log K) and memory stays O(K) however many words are offered.
+struct WcTopK {
+  struct WcTopEntry *heap;    // array of k entries, size of them in use
+  uint32_t size;
+  uint32_t k;
+};
+
+// The best K words of a dictionary whose counts are being increased,
+// kept up to date as each count goes up (so there is never a need to
+// scan the dictionary), in order from best to worst. Words are known by
+// their interned word pointers. An update costs O(K) in the worst case:
+// finding the word's entry is a linear search from the front (where the
+// frequent words are), and when many words are tied, one increment moves
+// a word ahead of every entry that had its old count.
+struct WcTopTracker {
+  struct WcTopEntry *entries; // array of k entries, size of them in use
+  uint32_t size;
+  uint32_t k;
+};
+
+// One counter of a WcSpaceSaving sketch
+struct WcSpaceSavingCounter {
+  unsigned char word[MAX_WORDLEN + 1];
+  uint32_t count;             // estimated count, never less than the real one
+  uint32_t error;             // most that count may be too high by
+  uint32_t hash;              // wc_hash of word
+  uint32_t heap_pos;          // index of this counter in the heap
+};
+
+// Space-Saving sketch for finding the most frequent words of an unbounded
+// stream in bounded memory: a fixed number of counters, each monitoring
+// one word. A word that isn't monitored takes over the counter with the
+// smallest count, inheriting that count as its error. Any word occurring
+// more than total/capacity times is guaranteed to be monitored.
+struct WcSpaceSaving {
+  struct WcSpaceSavingCounter *counters;
+  uint32_t *heap;             // counter indices, a min-heap by count
+  uint32_t *index;            // hashtable of (counter index + 1), 0 if empty
+  uint64_t index_mask;        // number of index slots - 1
+  uint32_t size;              // number of counters in use
+  uint32_t capacity;          // number of counters
+};
+
+// Input source for wc_reader_next. A regular file is mmap'ed as a whole,
+// so words are read straight out of the mapping; anything else (pipes,
+// terminals) is read in large blocks with read(). Either way, bytes
+// buf[pos..len-1] are the ones not scanned yet.
+//
+// The assembly implementation depends on the offsets of buf, len and pos.
+struct WcReader {
+  const unsigned char *buf; // data being scanned
+  uint64_t len;             // number of valid bytes in buf
+  uint64_t pos;             // index of the next byte to scan
+  unsigned char *block;     // read() buffer, NULL if the file is mapped
+  uint64_t block_size;      // size of the read() buffer
+  int fd;                   // file descriptor data comes from
+  int mapped;               // 1 if buf is an mmap of the whole file
+  int owns_fd;              // 1 if wc_reader_close should close fd
+};
+
+// One slot of a WcDict. The fingerprint is the word's hash code with the
+// top bit set, so that 0 marks an empty slot and most mismatches during
+// a probe are found without comparing words.
+//
+// The assembly implementation depends on the layout of this struct.
+struct WcDictSlot {
+  uint32_t fingerprint;       // 0 if the slot is empty
+  uint32_t count;             // number of occurrences of the word
+  const unsigned char *word;  // NUL-terminated copy of the word in the arena
+};
+
+// A block of the arena that a WcDict copies its words into
+struct WcDictChunk {
+  struct WcDictChunk *next;   // previously filled block
+  uint64_t used;              // number of bytes of data in use
+  uint64_t size;              // number of bytes of data
+  unsigned char data[];
+};
+
+// Dictionary of word counts: an open-addressing hashtable with linear
+// probing whose capacity is a power of 2, grown when it gets 3/4 full.
+// The slots hold no word bytes themselves (so 4 fit in a cache line);
+// words are interned into a list of large arena blocks, which also keeps
+// them in place when the table is resized.
+//
+// The assembly implementation depends on the offsets of slots, capacity
+// and size.
+struct WcDict {
+  struct WcDictSlot *slots;   // array of capacity slots
+  uint64_t capacity;          // number of slots, a power of 2
+  uint64_t size;              // number of slots in use (unique words)
+  struct WcDictChunk *arena;  // block words are currently copied into
+  int hash_kind;              // WC_HASH_DJB2 or WC_HASH_FAST
+};
+
+// A word found by wc_tokenize: the offset of its first byte and its
+// length in bytes.
+struct WcSpan {
+  uint64_t offset;
+  uint64_t len;
+};
+
+// Word-count index files (.wci) hold the counts of a dictionary so that
+// counts from separate runs can be combined without rereading the text.
+// A file is a 24-byte header:
+//
+//   "WCIX"  magic number
+//   uint32  format version (WC_INDEX_VERSION)
+//   uint64  total words (the sum of the counts)
+//   uint64  unique words (the number of records)
+//
+// (integers little-endian), followed by one record per word, in
+// increasing order of wc_str_compare:
+//
+//   varint  number of leading bytes shared with the previous word
+//           (the longest common prefix; 0 for the first word)
+//   varint  number of bytes that follow
+//   bytes   rest of the word
+//   varint  count
+//
+// where a varint is LEB128: 7 bits per byte, low bits first, with the
+// top bit set on every byte but the last. Records are only read front to
+// back, so a file can be mapped and read without loading it as a whole.
+#define WC_INDEX_MAGIC "WCIX"
+#define WC_INDEX_VERSION 1
+#define WC_INDEX_HEADER_SIZE 24
+
+// Writes an index file one word at a time. The header is written with
+// zero counts first and filled in by wc_index_writer_finish.
+struct WcIndexWriter {
+  FILE *out;                              // file being written
+  unsigned char prev[MAX_WORDLEN + 1];    // last word written
+  uint64_t prev_len;                      // length of prev
+  uint64_t total_words;                   // sum of the counts written
+  uint64_t unique_words;                  // number of records written
+  int ok;                                 // 0 once anything fails
+};
+
+// Reads the records of a mapped index file in order. After each call to
+// wc_index_reader_next, word and count are the current record's.
+struct WcIndexReader {
+  const unsigned char *data;              // the mapped file
+  uint64_t size;                          // number of bytes in data
+  uint64_t pos;                           // offset of the next record
+  uint64_t total_words;                   // from the header
+  uint64_t unique_words;                  // from the header
+  uint64_t words_left;                    // number of records not read yet
+  unsigned char word[MAX_WORDLEN + 1];    // current word (NUL-terminated)
+  uint64_t word_len;                      // length of word
+  uint64_t count;                         // current word's count
+};
+
+// K-way merge of index readers: a min-heap of the readers ordered by
+// their current words. After each call to wc_index_merge_next, word and
+// count are the next word of the combined indexes and its total count.
+struct WcIndexMerge {
+  struct WcIndexReader **inputs;          // readers being merged
+  unsigned *heap;                         // indexes of readers with words left
+  unsigned size;                          // number of readers in heap
+  unsigned char word[MAX_WORDLEN + 1];    // current word (NUL-terminated)
+  uint64_t count;                         // current word's total count
+};
+
 // Compute a hash code for the given NUL-terminated
 // character string.
 //
@@ -26,6 +229,12 @@ struct WordEntry {
 // being unsigned (in the range 0..255)
 uint32_t wc_hash(const unsigned char *w);
 
+// Compute a hash code for the len bytes of w, mixing 8 bytes at a time
+// with 64x64->128-bit multiplies (in the style of wyhash). This is much
+// faster than wc_hash for all but the shortest words, and its low bits,
+// which pick the slot in a table, depend on every byte of the word.
+uint32_t wc_hash_fast(const unsigned char *w, uint64_t len);
+
 // Compare two strings lexicographically. Return
 //
 // - a negative value if lhs string is less than rhs string
@@ -105,4 +314,218 @@ struct WordEntry *wc_dict_find_or_insert(struct WordEntry *buckets[], unsigned n
 // Free all of the nodes in given linked list of WordEntry objects.
 void wc_free_chain(struct WordEntry *p);
 
+// Allocate an (uninitialized) WordEntry object from the arena, or with
+// malloc if arena is NULL. Returns NULL if memory can't be allocated.
+struct WordEntry *wc_arena_alloc(struct WcEntryArena *arena);
+
+// Free every WordEntry allocated from the arena, leaving it empty.
+void wc_arena_free_all(struct WcEntryArena *arena);
+
+// Like wc_find_or_insert, but a new WordEntry object is allocated from
+// the arena (with malloc if arena is NULL). Returns NULL (leaving
+// *inserted unchanged) if memory can't be allocated.
+struct WordEntry *wc_find_or_insert_arena(struct WordEntry *head, const unsigned char *s, int *inserted,
+                                          struct WcEntryArena *arena);
+
+// Like wc_dict_find_or_insert, but a new WordEntry object is allocated
+// from the arena (with malloc if arena is NULL). Objects allocated from
+// an arena must be freed by wc_arena_free_all, not wc_free_chain.
+// Returns NULL (leaving the buckets unchanged) if memory can't be
+// allocated.
+struct WordEntry *wc_dict_find_or_insert_arena(struct WordEntry *buckets[], unsigned num_buckets,
+                                               const unsigned char *s, struct WcEntryArena *arena);
+
+// Create an empty open-addressing dictionary (see struct WcDict) using
+// the WC_DEFAULT_HASH hash function. Returns NULL if memory can't be
+// allocated.
+struct WcDict *wc_dict_create(void);
+
+// Like wc_dict_create, but using the given hash function (WC_HASH_DJB2
+// or WC_HASH_FAST).
+struct WcDict *wc_dict_create_hash(int hash_kind);
+
+// Hash code of the len bytes of w, using the dictionary's hash function.
+uint32_t wc_dict_hash(const struct WcDict *d, const unsigned char *w, uint64_t len);
+
+// Count the words of the dictionary by how many slots have to be probed
+// to find them: hist[i] is increased by the number of words found on
+// probe i+1 (the last element also counts all longer probes).
+void wc_dict_probe_histogram(const struct WcDict *d, uint64_t hist[], unsigned num_bins);
+
+// Return the slot for the word w, adding it with a count of 0 if it is
+// not in the dictionary yet. (It is the caller's job to update the count.)
+// Slot pointers are only valid until the next word is added, since the
+// table may be resized, but the slot's word pointer stays valid until the
+// dictionary is destroyed. Returns NULL if memory can't be allocated.
+struct WcDictSlot *wc_dict_intern(struct WcDict *d, const unsigned char *w);
+
+// Like wc_dict_intern, for a word whose hash code (from wc_dict_hash) or
+// fingerprint is already known, e.g. when merging dictionaries.
+struct WcDictSlot *wc_dict_intern_hash(struct WcDict *d, const unsigned char *w, uint32_t hash);
+
+// Return the slot for the word w, or NULL if it is not in the dictionary.
+struct WcDictSlot *wc_dict_find(struct WcDict *d, const unsigned char *w);
+
+// Free the dictionary's table, its arena and the dictionary itself.
+void wc_dict_destroy(struct WcDict *d);
+
+// Count every word of buf[0..len-1] into d the way the wordcount program
+// does: each word is truncated to MAX_WORDLEN characters, lowercased and
+// has its trailing non-letters removed. The number of words is stored in
+// *total_words. Returns 0 if memory can't be allocated.
+int wc_count_words(struct WcDict *d, const unsigned char *buf, uint64_t len, uint64_t *total_words);
+
+// Like wc_count_words, but using nthreads threads: buf is split at
+// whitespace into nthreads chunks, each counted into its own dictionary
+// (using the hash function hash_kind),
+// and then the dictionaries are merged in parallel, each thread merging
+// the words whose hash codes fall in its partition. The result is the
+// nthreads new dictionaries stored in parts (which the caller must
+// destroy), each word being in exactly one of them. Returns 0 (with
+// every element of parts NULL) if memory can't be allocated or a thread
+// can't be created.
+int wc_count_words_parallel(const unsigned char *buf, uint64_t len, unsigned nthreads, int hash_kind,
+                            struct WcDict *parts[], uint64_t *total_words);
+
+// Start writing an index to out, which must be a new (or empty),
+// seekable file opened for writing. The caller closes out once
+// wc_index_writer_finish has been called. Returns 0 if the header can't
+// be written.
+int wc_index_writer_init(struct WcIndexWriter *w, FILE *out);
+
+// Add a word (at most MAX_WORDLEN characters) and its count to the
+// index. Words must be added in strictly increasing order of
+// wc_str_compare. Returns 0 if the word is out of order or too long, or
+// if writing fails.
+int wc_index_writer_add(struct WcIndexWriter *w, const unsigned char *word, uint64_t count);
+
+// Fill in the header and flush the file. Returns 0 if any step of
+// writing the index failed.
+int wc_index_writer_finish(struct WcIndexWriter *w);
+
+// Write every word of the dictionaries (in which no word appears
+// twice), sorted, to an index in the named file. Returns 0 if memory
+// can't be allocated or the file can't be written.
+int wc_index_write_dicts(const char *filename, struct WcDict *dicts[], unsigned num_dicts);
+
+// Map the index file open on fd (which the reader doesn't close) and
+// check its header. Returns NULL if the file can't be mapped or isn't an
+// index.
+struct WcIndexReader *wc_index_reader_open_fd(int fd);
+
+// Like wc_index_reader_open_fd, but for the named file.
+struct WcIndexReader *wc_index_reader_open(const char *filename);
+
+// Read the next record. Returns 1 if there was one, 0 at the end of the
+// index, or -1 if the file is corrupt (a record runs past the end of the
+// file, a word is too long or out of order, or the record count in the
+// header is wrong).
+int wc_index_reader_next(struct WcIndexReader *r);
+
+// Unmap the file and free the reader.
+void wc_index_reader_close(struct WcIndexReader *r);
+
+// Start merging the n index readers, none of which has been read yet.
+// Returns 1 on success, 0 if memory can't be allocated, or -1 if one of
+// the files is corrupt.
+int wc_index_merge_init(struct WcIndexMerge *m, struct WcIndexReader *inputs[], unsigned n);
+
+// Find the next word of the merged indexes, adding up its counts from
+// every reader that has it. Returns 1 if there was a word, 0 at the end
+// of every index, or -1 if one of the files is corrupt.
+int wc_index_merge_next(struct WcIndexMerge *m);
+
+// Free the memory used by m (but not the readers).
+void wc_index_merge_free(struct WcIndexMerge *m);
+
+// Make t an empty WcTopK keeping the best k (at least 1) words. Returns
+// 0 if memory can't be allocated.
+int wc_topk_init(struct WcTopK *t, uint32_t k);
+
+// Offer a word with its count (and error, 0 for an exact count) to t,
+// which keeps it if it is one of the best k words offered so far. Only
+// the pointer to word is kept, so it must stay valid while t is used.
+void wc_topk_offer(struct WcTopK *t, const unsigned char *word, uint32_t count, uint32_t error);
+
+// Offer every word of the dictionary to t.
+void wc_topk_offer_dict(struct WcTopK *t, const struct WcDict *d);
+
+// Sort t's entries from best to worst, returning how many there are.
+// No more words may be offered afterwards.
+uint32_t wc_topk_sort(struct WcTopK *t);
+
+// Free the memory used by t.
+void wc_topk_free(struct WcTopK *t);
+
+// Make t an empty WcTopTracker for the best k (at least 1) words.
+// Returns 0 if memory can't be allocated.
+int wc_top_tracker_init(struct WcTopTracker *t, uint32_t k);
+
+// Tell t that the count of word (a pointer that stays the same for the
+// word, such as the word of a WcDictSlot) was increased to count.
+// Counts must only increase by one at a time.
+void wc_top_tracker_update(struct WcTopTracker *t, const unsigned char *word, uint32_t count);
+
+// Free the memory used by t.
+void wc_top_tracker_free(struct WcTopTracker *t);
+
+// Make ss an empty Space-Saving sketch with the given number (at least
+// 1) of counters. Returns 0 if memory can't be allocated.
+int wc_space_saving_init(struct WcSpaceSaving *ss, uint32_t capacity);
+
+// Count one occurrence of the word w (at most MAX_WORDLEN characters) in
+// ss, in O(log capacity) time.
+void wc_space_saving_add(struct WcSpaceSaving *ss, const unsigned char *w);
+
+// Offer every monitored word of ss, with its estimated count and error,
+// to t. The word pointers are only valid until the next word is added.
+void wc_space_saving_offer_top(const struct WcSpaceSaving *ss, struct WcTopK *t);
+
+// Free the memory used by ss.
+void wc_space_saving_free(struct WcSpaceSaving *ss);
+
+// Open the named file for reading with wc_reader_next. Regular files
+// are mmap'ed; other files are read in blocks. Returns NULL if the file
+// can't be opened.
+struct WcReader *wc_reader_open(const char *filename);
+
+// Like wc_reader_open, but for an already-open file descriptor (e.g., 0
+// for stdin), which wc_reader_close will not close. Reading starts at the
+// descriptor's current offset.
+struct WcReader *wc_reader_open_fd(int fd);
+
+// Like wc_reader_open_fd, but always reads blocks of the given size with
+// read(), even if fd is a regular file.
+struct WcReader *wc_reader_open_fd_buffered(int fd, uint64_t block_size);
+
+// Make more input available once buf[pos..len-1] has been used up.
+// Returns 1 if there is more data, 0 at end of input.
+int wc_reader_fill(struct WcReader *r);
+
+// Read the next word from the reader into w, exactly like wc_readnext
+// does from a FILE (same definition of a word, same truncation to
+// MAX_WORDLEN characters). Returns 1 if a word was read, 0 at end of input.
+int wc_reader_next(struct WcReader *r, unsigned char *w);
+
+// Find the words in buf[0..len-1] (runs of non-whitespace bytes, the
+// same as for wc_readnext), storing the span of each word in spans, up
+// to max_spans of them. If lower is not NULL, it must have room for len
+// bytes, and the bytes of every word found are stored at the same offsets
+// in lower with 'A'-'Z' converted to lower case.
+//
+// A word running into the end of buf is only stored if at_end is nonzero,
+// since otherwise it might continue in the next buffer. *consumed is set
+// to the number of bytes fully processed, i.e., where the next call should
+// start. Returns the number of spans stored.
+//
+// The bytes are classified (and lowercased) 64 at a time with SIMD
+// instructions, and word boundaries are found by bit scans of the
+// resulting masks.
+uint64_t wc_tokenize(const unsigned char *buf, uint64_t len, int at_end, unsigned char *lower,
+                     struct WcSpan *spans, uint64_t max_spans, uint64_t *consumed);
+
+// Unmap or free the reader's buffer, close its file (if it was opened
+// by wc_reader_open), and free the reader.
+void wc_reader_close(struct WcReader *r);
+
 #endif // WCFUNCS_H
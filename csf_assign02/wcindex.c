@@ -0,0 +1,311 @@
+// Word-count index files: writing them (from WcDicts, or a word at a
+// time), reading them through a mapping, and merging several of them.
+// The file format is described in wcfuncs.h.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "wcfuncs.h"
+
+// Store v at p as 'size' little-endian bytes
+static void wc_index_put_le(unsigned char *p, uint64_t v, unsigned size) {
+  for (unsigned i = 0; i < size; i++) {
+    p[i] = (unsigned char) (v >> (8 * i));
+  }
+}
+
+static uint64_t wc_index_get_le(const unsigned char *p, unsigned size) {
+  uint64_t v = 0;
+  for (unsigned i = 0; i < size; i++) {
+    v |= (uint64_t) p[i] << (8 * i);
+  }
+  return v;
+}
+
+// Write the header with the writer's current counts at the current
+// position of the file
+static int wc_index_write_header(struct WcIndexWriter *w) {
+  unsigned char header[WC_INDEX_HEADER_SIZE];
+  memcpy(header, WC_INDEX_MAGIC, 4);
+  wc_index_put_le(header + 4, WC_INDEX_VERSION, 4);
+  wc_index_put_le(header + 8, w->total_words, 8);
+  wc_index_put_le(header + 16, w->unique_words, 8);
+  return fwrite(header, 1, sizeof(header), w->out) == sizeof(header);
+}
+
+static void wc_index_put_varint(struct WcIndexWriter *w, uint64_t v) {
+  while (v >= 0x80) {
+    fputc((int) (v & 0x7f) | 0x80, w->out);
+    v >>= 7;
+  }
+  fputc((int) v, w->out);
+}
+
+int wc_index_writer_init(struct WcIndexWriter *w, FILE *out) {
+  w->out = out;
+  w->prev[0] = '\0';
+  w->prev_len = 0;
+  w->total_words = 0;
+  w->unique_words = 0;
+  w->ok = wc_index_write_header(w);
+  return w->ok;
+}
+
+int wc_index_writer_add(struct WcIndexWriter *w, const unsigned char *word, uint64_t count) {
+  uint64_t len = strlen((const char *) word);
+  if (len > MAX_WORDLEN || (w->unique_words > 0 && wc_str_compare(w->prev, word) >= 0)) {
+    w->ok = 0;
+  }
+  if (!w->ok) {
+    return 0;
+  }
+  // only the part of the word that differs from the previous one is
+  // stored (sorted words share long prefixes)
+  uint64_t prefix = 0;
+  while (prefix < w->prev_len && w->prev[prefix] == word[prefix]) {
+    prefix++;
+  }
+  wc_index_put_varint(w, prefix);
+  wc_index_put_varint(w, len - prefix);
+  fwrite(word + prefix, 1, len - prefix, w->out);
+  wc_index_put_varint(w, count);
+
+  memcpy(w->prev + prefix, word + prefix, len - prefix + 1);
+  w->prev_len = len;
+  w->total_words += count;
+  w->unique_words++;
+  return 1;
+}
+
+int wc_index_writer_finish(struct WcIndexWriter *w) {
+  // the counts are only known now, so go back and rewrite the header
+  w->ok = w->ok && fseek(w->out, 0, SEEK_SET) == 0 && wc_index_write_header(w);
+  w->ok = w->ok && fflush(w->out) == 0 && !ferror(w->out);
+  return w->ok;
+}
+
+// Order dictionary slots by their words, for qsort
+static int wc_index_compare_slots(const void *a, const void *b) {
+  const struct WcDictSlot *const *x = a;
+  const struct WcDictSlot *const *y = b;
+  return wc_str_compare((*x)->word, (*y)->word);
+}
+
+int wc_index_write_dicts(const char *filename, struct WcDict *dicts[], unsigned num_dicts) {
+  uint64_t n = 0;
+  for (unsigned d = 0; d < num_dicts; d++) {
+    n += dicts[d]->size;
+  }
+  const struct WcDictSlot **sorted = malloc((n > 0 ? n : 1) * sizeof(struct WcDictSlot *));
+  if (sorted == NULL) {
+    return 0;
+  }
+  uint64_t i = 0;
+  for (unsigned d = 0; d < num_dicts; d++) {
+    for (uint64_t k = 0; k < dicts[d]->capacity; k++) {
+      if (dicts[d]->slots[k].fingerprint != 0) {
+        sorted[i++] = &dicts[d]->slots[k];
+      }
+    }
+  }
+  qsort(sorted, n, sizeof(struct WcDictSlot *), wc_index_compare_slots);
+
+  struct WcIndexWriter w;
+  FILE *out = fopen(filename, "wb");
+  int ok = out != NULL && wc_index_writer_init(&w, out);
+  for (i = 0; ok && i < n; i++) {
+    ok = wc_index_writer_add(&w, sorted[i]->word, sorted[i]->count);
+  }
+  ok = ok && wc_index_writer_finish(&w);
+  if (out != NULL && fclose(out) != 0) {
+    ok = 0;
+  }
+  free(sorted);
+  return ok;
+}
+
+struct WcIndexReader *wc_index_reader_open_fd(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < WC_INDEX_HEADER_SIZE) {
+    return NULL;
+  }
+  const unsigned char *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  if (memcmp(data, WC_INDEX_MAGIC, 4) != 0 || wc_index_get_le(data + 4, 4) != WC_INDEX_VERSION) {
+    munmap((void *) data, (size_t) st.st_size);
+    return NULL;
+  }
+  // records are read front to back, and each page only once
+  madvise((void *) data, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+  struct WcIndexReader *r = calloc(1, sizeof(struct WcIndexReader));
+  if (r == NULL) {
+    munmap((void *) data, (size_t) st.st_size);
+    return NULL;
+  }
+  r->data = data;
+  r->size = (uint64_t) st.st_size;
+  r->pos = WC_INDEX_HEADER_SIZE;
+  r->total_words = wc_index_get_le(data + 8, 8);
+  r->unique_words = wc_index_get_le(data + 16, 8);
+  r->words_left = r->unique_words;
+  return r;
+}
+
+struct WcIndexReader *wc_index_reader_open(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  // the mapping stays valid once the file is closed
+  struct WcIndexReader *r = wc_index_reader_open_fd(fd);
+  close(fd);
+  return r;
+}
+
+// Read a varint into *v. Returns 0 if it runs past the end of the file
+// or is too long for 64 bits.
+static int wc_index_get_varint(struct WcIndexReader *r, uint64_t *v) {
+  uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (r->pos >= r->size) {
+      return 0;
+    }
+    unsigned char b = r->data[r->pos++];
+    result |= (uint64_t) (b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      *v = result;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int wc_index_reader_next(struct WcIndexReader *r) {
+  if (r->words_left == 0) {
+    return r->pos == r->size ? 0 : -1;
+  }
+  int first = r->words_left == r->unique_words;
+  uint64_t prefix, len, count;
+  if (!wc_index_get_varint(r, &prefix) || !wc_index_get_varint(r, &len) ||
+      prefix > r->word_len || (first && prefix > 0) ||
+      len > MAX_WORDLEN - prefix || len > r->size - r->pos) {
+    return -1;
+  }
+  const unsigned char *rest = r->data + r->pos;
+  // every word must sort after the previous one, and the shared prefix
+  // must be the longest one
+  if (!first && (len == 0 || (prefix < r->word_len && rest[0] <= r->word[prefix]))) {
+    return -1;
+  }
+  if (memchr(rest, '\0', len) != NULL) {
+    return -1;
+  }
+  memcpy(r->word + prefix, rest, len);
+  r->word_len = prefix + len;
+  r->word[r->word_len] = '\0';
+  r->pos += len;
+  if (!wc_index_get_varint(r, &count)) {
+    return -1;
+  }
+  r->count = count;
+  r->words_left--;
+  return 1;
+}
+
+void wc_index_reader_close(struct WcIndexReader *r) {
+  if (r == NULL) {
+    return;
+  }
+  munmap((void *) r->data, r->size);
+  free(r);
+}
+
+// 1 if the current word of reader a sorts before that of reader b
+static int wc_index_merge_less(const struct WcIndexMerge *m, unsigned a, unsigned b) {
+  return wc_str_compare(m->inputs[a]->word, m->inputs[b]->word) < 0;
+}
+
+// Move heap entry i down until neither child's word sorts before its own
+static void wc_index_merge_sift_down(struct WcIndexMerge *m, unsigned i) {
+  unsigned e = m->heap[i];
+  for (;;) {
+    unsigned child = 2 * i + 1;
+    if (child >= m->size) {
+      break;
+    }
+    if (child + 1 < m->size && wc_index_merge_less(m, m->heap[child + 1], m->heap[child])) {
+      child++;
+    }
+    if (!wc_index_merge_less(m, m->heap[child], e)) {
+      break;
+    }
+    m->heap[i] = m->heap[child];
+    i = child;
+  }
+  m->heap[i] = e;
+}
+
+int wc_index_merge_init(struct WcIndexMerge *m, struct WcIndexReader *inputs[], unsigned n) {
+  m->inputs = inputs;
+  m->size = 0;
+  m->count = 0;
+  m->word[0] = '\0';
+  m->heap = malloc((n > 0 ? n : 1) * sizeof(unsigned));
+  if (m->heap == NULL) {
+    return 0;
+  }
+  for (unsigned t = 0; t < n; t++) {
+    int more = wc_index_reader_next(inputs[t]);
+    if (more < 0) {
+      wc_index_merge_free(m);
+      return -1;
+    }
+    if (more > 0) {
+      m->heap[m->size++] = t;
+    }
+  }
+  for (unsigned i = m->size / 2; i-- > 0; ) {
+    wc_index_merge_sift_down(m, i);
+  }
+  return 1;
+}
+
+int wc_index_merge_next(struct WcIndexMerge *m) {
+  if (m->size == 0) {
+    return 0;
+  }
+  const struct WcIndexReader *first = m->inputs[m->heap[0]];
+  memcpy(m->word, first->word, first->word_len + 1);
+  m->count = 0;
+  // every reader whose current word this is comes to the top of the
+  // heap in turn, once the ones before it have moved on
+  while (m->size > 0 && wc_str_compare(m->inputs[m->heap[0]]->word, m->word) == 0) {
+    struct WcIndexReader *r = m->inputs[m->heap[0]];
+    m->count += r->count;
+    int more = wc_index_reader_next(r);
+    if (more < 0) {
+      return -1;
+    }
+    if (more == 0) {
+      m->heap[0] = m->heap[--m->size];
+    }
+    if (m->size > 0) {
+      wc_index_merge_sift_down(m, 0);
+    }
+  }
+  return 1;
+}
+
+void wc_index_merge_free(struct WcIndexMerge *m) {
+  free(m->heap);
+  m->heap = NULL;
+  m->size = 0;
+}
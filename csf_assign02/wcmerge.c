@@ -0,0 +1,121 @@
+// wcmerge: combine the word counts of index files written by
+// "wordcount --save", without rereading the text they were counted from.
+//
+//   wcmerge [-o OUTPUT] INDEX...
+//
+// prints the statistics of the combined counts, and with -o writes them
+// to a new index file. The inputs are merged a word at a time, so only
+// the pages of each file being read need to be in memory.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wcfuncs.h"
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  int arg = 1;
+  if (arg + 1 < argc && strcmp(argv[arg], "-o") == 0) {
+    output = argv[arg + 1];
+    arg += 2;
+  }
+  if (arg >= argc) {
+    fprintf(stderr, "Usage: %s [-o OUTPUT] INDEX...\n", argv[0]);
+    return 1;
+  }
+
+  unsigned num_inputs = (unsigned) (argc - arg);
+  struct WcIndexReader **inputs = calloc(num_inputs, sizeof(struct WcIndexReader *));
+  if (inputs == NULL) {
+    fprintf(stderr, "Error: Out of memory.\n");
+    return 1;
+  }
+  int result = 0;
+  for (unsigned t = 0; result == 0 && t < num_inputs; t++) {
+    inputs[t] = wc_index_reader_open(argv[arg + t]);
+    if (inputs[t] == NULL) {
+      fprintf(stderr, "Error: Could not read index file '%s'.\n", argv[arg + t]);
+      result = 1;
+    }
+  }
+
+  // the output is written under a temporary name and renamed at the end,
+  // so that it can replace one of the inputs
+  char *temp_name = NULL;
+  FILE *out = NULL;
+  struct WcIndexWriter writer;
+  if (result == 0 && output != NULL) {
+    temp_name = malloc(strlen(output) + 5);
+    if (temp_name != NULL) {
+      sprintf(temp_name, "%s.tmp", output);
+      out = fopen(temp_name, "wb");
+    }
+    if (out == NULL || !wc_index_writer_init(&writer, out)) {
+      fprintf(stderr, "Error: Could not write index file '%s'.\n", output);
+      result = 1;
+    }
+  }
+
+  struct WcIndexMerge merge;
+  int status = 0;
+  if (result == 0) {
+    status = wc_index_merge_init(&merge, inputs, num_inputs);
+    if (status == 0) {
+      fprintf(stderr, "Error: Out of memory.\n");
+      result = 1;
+    }
+  }
+
+  uint64_t total_words = 0, unique_words = 0, best_word_count = 0;
+  unsigned char best_word[MAX_WORDLEN + 1] = "";
+  if (result == 0) {
+    while (status > 0 && (status = wc_index_merge_next(&merge)) > 0) {
+      total_words += merge.count;
+      unique_words++;
+      // words come in increasing order, so on a tie the earlier word
+      // (the lexicographically smaller one) stays the best
+      if (merge.count > best_word_count) {
+        best_word_count = merge.count;
+        memcpy(best_word, merge.word, sizeof(best_word));
+      }
+      if (out != NULL && !wc_index_writer_add(&writer, merge.word, merge.count)) {
+        break;
+      }
+    }
+    wc_index_merge_free(&merge);
+    if (status < 0) {
+      fprintf(stderr, "Error: Corrupt index file.\n");
+      result = 1;
+    } else if (out != NULL && !wc_index_writer_finish(&writer)) {
+      fprintf(stderr, "Error: Could not write index file '%s'.\n", output);
+      result = 1;
+    }
+  }
+
+  if (out != NULL) {
+    if (fclose(out) != 0 && result == 0) {
+      fprintf(stderr, "Error: Could not write index file '%s'.\n", output);
+      result = 1;
+    }
+    if (result == 0 && rename(temp_name, output) != 0) {
+      fprintf(stderr, "Error: Could not write index file '%s'.\n", output);
+      result = 1;
+    }
+    if (result != 0) {
+      remove(temp_name);
+    }
+  }
+  free(temp_name);
+  for (unsigned t = 0; t < num_inputs; t++) {
+    wc_index_reader_close(inputs[t]);
+  }
+  free(inputs);
+
+  if (result == 0) {
+    printf("Total words read: %lu\n", (unsigned long) total_words);
+    printf("Unique words read: %lu\n", (unsigned long) unique_words);
+    printf("Most frequent word: %s (%lu)\n", (const char *) best_word, (unsigned long) best_word_count);
+  }
+  return result;
+}
@@ -0,0 +1,109 @@
+// Setting up and refilling the input buffers used by wc_reader_next.
+// (wc_reader_next itself is in c_wcfuncs.c and asm_wcfuncs.S.)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "wcfuncs.h"
+
+// Size of the read() buffer for input that can't be mapped
+#define WC_READ_BLOCK_SIZE (1 << 20)
+
+struct WcReader *wc_reader_open(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct WcReader *r = wc_reader_open_fd(fd);
+  if (r == NULL) {
+    close(fd);
+    return NULL;
+  }
+  r->owns_fd = 1;
+  return r;
+}
+
+struct WcReader *wc_reader_open_fd(int fd) {
+  struct stat st;
+  // only regular files can be mapped; an empty file can't be mapped at all
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    return wc_reader_open_fd_buffered(fd, WC_READ_BLOCK_SIZE);
+  }
+  // start wherever the descriptor is, in case some input was already read
+  off_t start = lseek(fd, 0, SEEK_CUR);
+  if (start < 0 || start > st.st_size) {
+    start = 0;
+  }
+  void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return wc_reader_open_fd_buffered(fd, WC_READ_BLOCK_SIZE);
+  }
+  // the file is scanned front to back, so let the kernel read ahead
+  madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+  struct WcReader *r = calloc(1, sizeof(struct WcReader));
+  if (r == NULL) {
+    munmap(data, (size_t) st.st_size);
+    return NULL;
+  }
+  r->buf = data;
+  r->len = (uint64_t) st.st_size;
+  r->pos = (uint64_t) start;
+  r->fd = fd;
+  r->mapped = 1;
+  return r;
+}
+
+struct WcReader *wc_reader_open_fd_buffered(int fd, uint64_t block_size) {
+  struct WcReader *r = calloc(1, sizeof(struct WcReader));
+  if (r == NULL) {
+    return NULL;
+  }
+  r->block = malloc(block_size);
+  if (r->block == NULL) {
+    free(r);
+    return NULL;
+  }
+  r->block_size = block_size;
+  r->buf = r->block;
+  r->fd = fd;
+  return r;
+}
+
+int wc_reader_fill(struct WcReader *r) {
+  // a mapped file is all in memory from the start
+  if (r->mapped) {
+    return r->pos < r->len;
+  }
+  ssize_t n;
+  do {
+    n = read(r->fd, r->block, r->block_size);
+  } while (n < 0 && errno == EINTR);
+  // a read error is treated like the end of the input
+  if (n <= 0) {
+    r->len = r->pos = 0;
+    return 0;
+  }
+  r->len = (uint64_t) n;
+  r->pos = 0;
+  return 1;
+}
+
+void wc_reader_close(struct WcReader *r) {
+  if (r == NULL) {
+    return;
+  }
+  if (r->mapped) {
+    munmap((void *) r->buf, r->len);
+  } else {
+    free(r->block);
+  }
+  if (r->owns_fd) {
+    close(r->fd);
+  }
+  free(r);
+}
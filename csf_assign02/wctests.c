@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "tctest.h"
 #include "wcfuncs.h"
 
@@ -14,6 +16,7 @@ typedef struct {
   const unsigned char *test_str_1_copy;
 
   const unsigned char *words_1;
+  const unsigned char *words_2;
 } TestObjs;
 
 // Functions to create and clean up the test fixture object
@@ -25,6 +28,7 @@ FILE *create_input_file(const unsigned char *text);
 
 // Prototypes of test functions
 void test_hash(TestObjs *objs);
+void test_hash_fast(TestObjs *objs);
 void test_str_compare(TestObjs *objs);
 void test_str_copy(TestObjs *objs);
 void test_isspace(TestObjs *objs);
@@ -35,6 +39,17 @@ void test_trim_non_alpha(TestObjs *objs);
 void test_find_or_insert(TestObjs *objs);
 void test_dict_find_or_insert(TestObjs *objs);
 void test_free_chain(TestObjs *objs);
+void test_arena(TestObjs *objs);
+void test_reader_next(TestObjs *objs);
+void test_reader_next_buffered(TestObjs *objs);
+void test_tokenize(TestObjs *objs);
+void test_tokenize_random(TestObjs *objs);
+void test_dict_intern(TestObjs *objs);
+void test_count_words_parallel(TestObjs *objs);
+void test_topk(TestObjs *objs);
+void test_space_saving(TestObjs *objs);
+void test_top_tracker(TestObjs *objs);
+void test_index(TestObjs *objs);
 
 int main(int argc, char **argv) {
   // If a command line argument is provided, use it as the
@@ -46,6 +61,7 @@ int main(int argc, char **argv) {
   TEST_INIT();
 
   TEST(test_hash);
+  TEST(test_hash_fast);
   TEST(test_str_compare);
   TEST(test_str_copy);
   TEST(test_isspace);
@@ -56,6 +72,17 @@ int main(int argc, char **argv) {
   TEST(test_find_or_insert);
   TEST(test_dict_find_or_insert);
   TEST(test_free_chain);
+  TEST(test_arena);
+  TEST(test_reader_next);
+  TEST(test_reader_next_buffered);
+  TEST(test_tokenize);
+  TEST(test_tokenize_random);
+  TEST(test_dict_intern);
+  TEST(test_count_words_parallel);
+  TEST(test_topk);
+  TEST(test_space_saving);
+  TEST(test_top_tracker);
+  TEST(test_index);
 
   TEST_FINI();
 }
@@ -73,6 +100,10 @@ TestObjs *setup(void) {
   objs->test_str_1_copy = (const unsigned char *) "hello";
 
   objs->words_1 = (const unsigned char *) "A strong smell of petroleum prevails throughout.";
+  // leading/trailing whitespace of every kind, and a word longer than MAX_WORDLEN
+  objs->words_2 = (const unsigned char *)
+    " \t\r\n\f\vfirst\tsecond\n\n"
+    "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz last \n";
 
   //printf("%u\n", wc_hash("Burris"));
   //printf("%u\n", wc_hash("Burt's"));
@@ -118,10 +149,55 @@ void test_hash(TestObjs *objs) {
   ASSERT(261238937U == hash);
 }
 
+void test_hash_fast(TestObjs *objs) {
+  // the C and assembly versions must agree on these
+  ASSERT(153611260u == wc_hash_fast((const unsigned char *) "", 0));
+  ASSERT(3877004192u == wc_hash_fast((const unsigned char *) "a", 1));
+  ASSERT(4085192403u == wc_hash_fast(objs->test_str_1, 5));
+  ASSERT(293388387u == wc_hash_fast((const unsigned char *) "abcdefgh", 8));
+  ASSERT(237382670u == wc_hash_fast((const unsigned char *) "abcdefghi", 9));
+  ASSERT(1192851540u == wc_hash_fast(objs->test_str_2, 35));
+
+  // only the len bytes are hashed, and every one of them matters
+  unsigned char buf[32];
+  memset(buf, 'x', sizeof(buf));
+  uint32_t h = wc_hash_fast(buf, 20);
+  buf[20] = 'y';
+  ASSERT(h == wc_hash_fast(buf, 20));
+  ASSERT(h != wc_hash_fast(buf, 21));
+  for (int i = 0; i < 20; i++) {
+    buf[i] = 'y';
+    ASSERT(h != wc_hash_fast(buf, 20));
+    buf[i] = 'x';
+  }
+  ASSERT(h == wc_hash_fast(buf, 20));
+
+  // a dictionary using it works the same as one using wc_hash
+  struct WcDict *d = wc_dict_create_hash(WC_HASH_FAST);
+  unsigned char word[MAX_WORDLEN + 1];
+  for (int i = 0; i < 5000; i++) {
+    sprintf((char *) word, "word%d", i % 3000);
+    wc_dict_intern(d, word)->count++;
+  }
+  ASSERT(3000 == d->size);
+  ASSERT(2 == wc_dict_find(d, (const unsigned char *) "word1999")->count);
+  ASSERT(1 == wc_dict_find(d, (const unsigned char *) "word2999")->count);
+  ASSERT(NULL == wc_dict_find(d, (const unsigned char *) "word3000"));
+  // every word is in the histogram once
+  uint64_t hist[4] = { 0, 0, 0, 0 };
+  wc_dict_probe_histogram(d, hist, 4);
+  ASSERT(3000 == hist[0] + hist[1] + hist[2] + hist[3]);
+  ASSERT(hist[0] > hist[3]);
+  wc_dict_destroy(d);
+}
+
 void test_str_compare(TestObjs *objs) {
   ASSERT(wc_str_compare(objs->test_str_1, objs->test_str_1) == 0);
   ASSERT(wc_str_compare(objs->test_str_1, objs->test_str_4) < 0);
   ASSERT(wc_str_compare(objs->test_str_4, objs->test_str_1) > 0);
+  // bytes compare as unsigned, so non-ASCII bytes sort after ASCII ones
+  ASSERT(wc_str_compare((const unsigned char *) "caf\xc3\xa9", (const unsigned char *) "cafe") > 0);
+  ASSERT(wc_str_compare((const unsigned char *) "z", (const unsigned char *) "\x80") < 0);
 }
 
 void test_str_copy(TestObjs *objs) {
@@ -354,3 +430,596 @@ void test_free_chain(TestObjs *objs) {
 
   wc_free_chain(p);
 }
+
+void test_arena(TestObjs *objs) {
+  struct WcEntryArena arena = { NULL, 0 };
+  struct WordEntry *dict[5] = { NULL, NULL, NULL, NULL, NULL };
+  struct WordEntry *p, *q;
+  int inserted;
+
+  // entries come from one block, one after the other
+  p = wc_arena_alloc(&arena);
+  q = wc_arena_alloc(&arena);
+  ASSERT(p != NULL && q == p + 1);
+  ASSERT(2 == arena.used);
+  ASSERT(p == &arena.blocks->entries[0]);
+
+  inserted = -1;
+  p = wc_find_or_insert_arena(NULL, objs->test_str_1, &inserted, &arena);
+  ASSERT(1 == inserted);
+  ASSERT(q + 1 == p);
+  ASSERT(0 == strcmp("hello", (const char *) p->word));
+  ASSERT(0 == p->count);
+  ASSERT(NULL == p->next);
+  inserted = -1;
+  ASSERT(p == wc_find_or_insert_arena(p, objs->test_str_1, &inserted, &arena));
+  ASSERT(0 == inserted);
+
+  // fill more than one block through the dictionary
+  unsigned char word[MAX_WORDLEN + 1];
+  for (int i = 0; i < 3 * WC_ARENA_BLOCK_ENTRIES; i++) {
+    sprintf((char *) word, "word%d", i % 2000);
+    p = wc_dict_find_or_insert_arena(dict, 5, word, &arena);
+    ASSERT(0 == strcmp((const char *) word, (const char *) p->word));
+    p->count++;
+  }
+  ASSERT(NULL != arena.blocks->next);
+  ASSERT(NULL == arena.blocks->next->next);
+  ASSERT(3 + 2000 - WC_ARENA_BLOCK_ENTRIES == arena.used);
+  ASSERT(2 == wc_dict_find_or_insert_arena(dict, 5, (const unsigned char *) "word0", &arena)->count);
+  ASSERT(1 == wc_dict_find_or_insert_arena(dict, 5, (const unsigned char *) "word1999", &arena)->count);
+
+  // everything is freed at once
+  wc_arena_free_all(&arena);
+  ASSERT(NULL == arena.blocks);
+  ASSERT(0 == arena.used);
+  wc_arena_free_all(&arena);
+
+  // without an arena, entries are malloc'ed
+  p = wc_arena_alloc(NULL);
+  ASSERT(p != NULL);
+  free(p);
+}
+
+// Read all of words_2 from the reader, checking every word
+static void check_words_2(struct WcReader *r) {
+  unsigned char buf[MAX_WORDLEN + 1];
+
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(0 == strcmp("first", (const char *) buf));
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(0 == strcmp("second", (const char *) buf));
+  // only the first MAX_WORDLEN characters are kept
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(MAX_WORDLEN == strlen((const char *) buf));
+  ASSERT(0 == strncmp("abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijk", (const char *) buf, MAX_WORDLEN));
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(0 == strcmp("last", (const char *) buf));
+  ASSERT(0 == wc_reader_next(r, buf));
+  ASSERT(0 == wc_reader_next(r, buf));
+}
+
+void test_reader_next(TestObjs *objs) {
+  FILE *in;
+  struct WcReader *r;
+  unsigned char buf[MAX_WORDLEN + 1];
+
+  // a temporary file is a regular file, so it gets mapped
+  in = create_input_file(objs->words_1);
+  r = wc_reader_open_fd(fileno(in));
+  ASSERT(r != NULL);
+  ASSERT(1 == r->mapped);
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(0 == strcmp("A", (const char *) buf));
+  ASSERT(1 == wc_reader_next(r, buf));
+  ASSERT(0 == strcmp("strong", (const char *) buf));
+  wc_reader_close(r);
+  fclose(in);
+
+  in = create_input_file(objs->words_2);
+  r = wc_reader_open_fd(fileno(in));
+  check_words_2(r);
+  wc_reader_close(r);
+  fclose(in);
+
+  // an empty file has no words
+  in = create_input_file((const unsigned char *) "");
+  r = wc_reader_open_fd(fileno(in));
+  ASSERT(r != NULL);
+  ASSERT(0 == wc_reader_next(r, buf));
+  wc_reader_close(r);
+  fclose(in);
+}
+
+void test_reader_next_buffered(TestObjs *objs) {
+  // tiny blocks, so that whitespace runs and words (including the
+  // truncated one) are split across refills
+  for (uint64_t block_size = 1; block_size <= 8; block_size++) {
+    FILE *in = create_input_file(objs->words_2);
+    struct WcReader *r = wc_reader_open_fd_buffered(fileno(in), block_size);
+    ASSERT(r != NULL);
+    ASSERT(0 == r->mapped);
+    check_words_2(r);
+    wc_reader_close(r);
+    fclose(in);
+  }
+}
+
+void test_tokenize(TestObjs *objs) {
+  const unsigned char *text = objs->words_2;
+  uint64_t len = strlen((const char *) text);
+  unsigned char lower[128];
+  struct WcSpan spans[8];
+  uint64_t consumed;
+
+  // the long word crosses the first 64-byte block boundary
+  ASSERT(105 == len);
+  ASSERT(4 == wc_tokenize(text, len, 1, lower, spans, 8, &consumed));
+  ASSERT(len == consumed);
+  ASSERT(6 == spans[0].offset && 5 == spans[0].len);
+  ASSERT(12 == spans[1].offset && 6 == spans[1].len);
+  ASSERT(20 == spans[2].offset && 78 == spans[2].len);
+  ASSERT(99 == spans[3].offset && 4 == spans[3].len);
+  ASSERT(0 == memcmp("second", lower + 12, 6));
+
+  // a word running into the end of the buffer is left for the next call
+  // unless at_end is set
+  ASSERT(3 == wc_tokenize(text, 102, 0, NULL, spans, 8, &consumed));
+  ASSERT(99 == consumed);
+  ASSERT(4 == wc_tokenize(text, 102, 1, NULL, spans, 8, &consumed));
+  ASSERT(102 == consumed);
+  ASSERT(99 == spans[3].offset && 3 == spans[3].len);
+  ASSERT(0 == wc_tokenize(text + 20, 50, 0, NULL, spans, 8, &consumed));
+  ASSERT(0 == consumed);
+
+  // when spans fills up, consumed is the end of the last word stored
+  ASSERT(2 == wc_tokenize(text, len, 1, NULL, spans, 2, &consumed));
+  ASSERT(18 == consumed);
+  ASSERT(0 == wc_tokenize(text, len, 1, NULL, spans, 0, &consumed));
+  ASSERT(0 == consumed);
+
+  // every letter is lowercased, and everything else copied unchanged
+  const unsigned char *mixed = objs->test_str_2;
+  uint64_t mixed_len = strlen((const char *) mixed);
+  ASSERT(6 == wc_tokenize(mixed, mixed_len, 1, lower, spans, 8, &consumed));
+  ASSERT(0 == memcmp("this is a sentence with_mixed case.", lower, mixed_len));
+  ASSERT(30 == spans[5].offset && 5 == spans[5].len);
+}
+
+void test_tokenize_random(TestObjs *objs) {
+  // random buffers, mostly of word characters with a few of each kind of
+  // whitespace, checked against a byte-at-a-time scan
+  const unsigned char alphabet[] = "aZ-. \t\n\r\f\vqQ\xff\x80";
+  unsigned char buf[300], lower[300];
+  struct WcSpan spans[300];
+  srand(12345);
+  for (int iter = 0; iter < 2000; iter++) {
+    uint64_t len = (uint64_t) (rand() % 300);
+    for (uint64_t i = 0; i < len; i++) {
+      buf[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+    int at_end = rand() & 1;
+    uint64_t consumed;
+    uint64_t n = wc_tokenize(buf, len, at_end, lower, spans, 300, &consumed);
+
+    uint64_t k = 0, i = 0, expected_consumed = len;
+    while (i < len) {
+      if (wc_isspace(buf[i])) {
+        ASSERT(lower[i] == buf[i]);
+        i++;
+        continue;
+      }
+      uint64_t start = i;
+      while (i < len && !wc_isspace(buf[i])) {
+        unsigned char c = buf[i];
+        ASSERT(lower[i] == ((c >= 'A' && c <= 'Z') ? c + 32 : c));
+        i++;
+      }
+      if (i == len && !at_end) {
+        expected_consumed = start;
+        break;
+      }
+      ASSERT(k < n);
+      ASSERT(start == spans[k].offset && i - start == spans[k].len);
+      k++;
+    }
+    ASSERT(k == n);
+    ASSERT(expected_consumed == consumed);
+  }
+}
+
+void test_dict_intern(TestObjs *objs) {
+  struct WcDict *d = wc_dict_create();
+  ASSERT(d != NULL);
+  ASSERT(0 == d->size);
+  ASSERT(NULL == wc_dict_find(d, objs->test_str_1));
+
+  // a new word starts with a count of 0, and is copied
+  unsigned char buf[MAX_WORDLEN + 1];
+  strcpy((char *) buf, "hello");
+  struct WcDictSlot *slot = wc_dict_intern(d, buf);
+  ASSERT(slot != NULL);
+  ASSERT(0 == slot->count);
+  ASSERT(slot->fingerprint != 0);
+  ASSERT(slot->word != buf);
+  slot->count = 3;
+  strcpy((char *) buf, "world");
+  ASSERT(wc_dict_find(d, objs->test_str_1) == slot);
+  ASSERT(3 == wc_dict_intern(d, objs->test_str_1)->count);
+  ASSERT(1 == d->size);
+  // the empty string (e.g. a word that was all punctuation) is a word too
+  ASSERT(0 == wc_dict_intern(d, (const unsigned char *) "")->count);
+  ASSERT(2 == d->size);
+  ASSERT(wc_dict_find(d, (const unsigned char *) "") != NULL);
+
+  // add enough words to resize the table several times; words keep
+  // their counts, and their copies stay in place
+  const unsigned char *hello_copy = slot->word;
+  uint64_t initial_capacity = d->capacity;
+  for (int i = 0; i < 20000; i++) {
+    sprintf((char *) buf, "w%d", i);
+    slot = wc_dict_intern(d, buf);
+    ASSERT(slot != NULL);
+    slot->count += (uint32_t) i + 1;
+  }
+  ASSERT(20002 == d->size);
+  ASSERT(d->capacity > initial_capacity);
+  ASSERT(d->size * 4 <= d->capacity * 3);
+  ASSERT(wc_dict_find(d, objs->test_str_1)->word == hello_copy);
+  ASSERT(3 == wc_dict_find(d, objs->test_str_1)->count);
+  for (int i = 0; i < 20000; i++) {
+    sprintf((char *) buf, "w%d", i);
+    slot = wc_dict_find(d, buf);
+    ASSERT(slot != NULL);
+    ASSERT((uint32_t) i + 1 == slot->count);
+    ASSERT(0 == strcmp((const char *) buf, (const char *) slot->word));
+  }
+  ASSERT(NULL == wc_dict_find(d, (const unsigned char *) "w20000"));
+
+  // every word is in exactly one slot
+  uint64_t used = 0;
+  for (uint64_t i = 0; i < d->capacity; i++) {
+    if (d->slots[i].fingerprint != 0) {
+      used++;
+    }
+  }
+  ASSERT(d->size == used);
+
+  wc_dict_destroy(d);
+}
+
+void test_count_words_parallel(TestObjs *objs) {
+  // a buffer of random words, some repeated, some differing only in
+  // case or trailing punctuation, and one longer than MAX_WORDLEN
+  static const char *vocab[] = { "the", "The", "THE.", "cat", "cat,", "sat", "on", "mat", "!!", "x" };
+  uint64_t cap = 200000, len = 0;
+  unsigned char *buf = malloc(cap);
+  srand(4242);
+  while (len < cap - 200) {
+    const char *w = vocab[rand() % 10];
+    len += (uint64_t) sprintf((char *) buf + len, "%s%c", w, " \n\t"[rand() % 3]);
+    if (rand() % 1000 == 0) {
+      len += (uint64_t) sprintf((char *) buf + len, "w%d ", rand() % 5000);
+    }
+  }
+  memset(buf + len, 'q', 100);
+  len += 100;
+
+  struct WcDict *expected = wc_dict_create();
+  uint64_t expected_total;
+  ASSERT(wc_count_words(expected, buf, len, &expected_total));
+  ASSERT(wc_dict_find(expected, (const unsigned char *) "the")->count > 0);
+  ASSERT(NULL == wc_dict_find(expected, (const unsigned char *) "The"));
+
+  for (unsigned nthreads = 1; nthreads <= 8; nthreads++) {
+    struct WcDict *parts[8];
+    uint64_t total;
+    ASSERT(wc_count_words_parallel(buf, len, nthreads, nthreads % 2 ? WC_HASH_DJB2 : WC_HASH_FAST, parts, &total));
+    ASSERT(expected_total == total);
+    uint64_t unique = 0;
+    for (unsigned t = 0; t < nthreads; t++) {
+      unique += parts[t]->size;
+      for (uint64_t i = 0; i < parts[t]->capacity; i++) {
+        const struct WcDictSlot *slot = &parts[t]->slots[i];
+        if (slot->fingerprint == 0) {
+          continue;
+        }
+        // same count as counting with one thread
+        const struct WcDictSlot *e = wc_dict_find(expected, slot->word);
+        ASSERT(e != NULL);
+        ASSERT(e->count == slot->count);
+      }
+    }
+    // no word is in two of the dictionaries
+    ASSERT(expected->size == unique);
+    for (unsigned t = 0; t < nthreads; t++) {
+      wc_dict_destroy(parts[t]);
+    }
+  }
+
+  wc_dict_destroy(expected);
+  free(buf);
+}
+
+void test_topk(TestObjs *objs) {
+  struct WcTopK top;
+
+  // ties are broken the same way as for the most frequent word
+  ASSERT(wc_topk_init(&top, 3));
+  wc_topk_offer(&top, (const unsigned char *) "b", 5, 0);
+  wc_topk_offer(&top, (const unsigned char *) "z", 1, 0);
+  wc_topk_offer(&top, (const unsigned char *) "c", 5, 0);
+  wc_topk_offer(&top, (const unsigned char *) "y", 1, 0);
+  wc_topk_offer(&top, (const unsigned char *) "a", 5, 0);
+  wc_topk_offer(&top, (const unsigned char *) "d", 5, 0);
+  wc_topk_offer(&top, (const unsigned char *) "x", 9, 0);
+  ASSERT(3 == wc_topk_sort(&top));
+  ASSERT(0 == strcmp("x", (const char *) top.heap[0].word));
+  ASSERT(9 == top.heap[0].count);
+  ASSERT(0 == strcmp("a", (const char *) top.heap[1].word));
+  ASSERT(0 == strcmp("b", (const char *) top.heap[2].word));
+  wc_topk_free(&top);
+
+  // the top words of a dictionary, against sorting all of them
+  struct WcDict *d = wc_dict_create();
+  unsigned char word[MAX_WORDLEN + 1];
+  srand(777);
+  for (int i = 0; i < 20000; i++) {
+    sprintf((char *) word, "w%d", rand() % (1 + rand() % 3000));
+    wc_dict_intern(d, word)->count++;
+  }
+  ASSERT(wc_topk_init(&top, 50));
+  wc_topk_offer_dict(&top, d);
+  ASSERT(50 == wc_topk_sort(&top));
+  for (uint32_t i = 0; i < 50; i++) {
+    // exactly i words of the dictionary are better than entry i
+    uint32_t better = 0;
+    for (uint64_t j = 0; j < d->capacity; j++) {
+      const struct WcDictSlot *slot = &d->slots[j];
+      if (slot->fingerprint != 0 &&
+          (slot->count > top.heap[i].count ||
+           (slot->count == top.heap[i].count && wc_str_compare(slot->word, top.heap[i].word) < 0))) {
+        better++;
+      }
+    }
+    ASSERT(i == better);
+  }
+  wc_topk_free(&top);
+
+  // fewer words than K
+  ASSERT(wc_topk_init(&top, 100));
+  wc_topk_offer(&top, objs->test_str_1, 2, 0);
+  ASSERT(1 == wc_topk_sort(&top));
+  wc_topk_free(&top);
+  wc_dict_destroy(d);
+}
+
+void test_space_saving(TestObjs *objs) {
+  struct WcSpaceSaving ss;
+  struct WcTopK top;
+  unsigned char word[MAX_WORDLEN + 1];
+
+  // with a counter for every word, the counts are exact
+  ASSERT(wc_space_saving_init(&ss, 10));
+  for (int i = 0; i < 100; i++) {
+    sprintf((char *) word, "w%d", i % 10 < 5 ? 0 : i % 10);
+    wc_space_saving_add(&ss, word);
+  }
+  ASSERT(6 == ss.size);
+  ASSERT(wc_topk_init(&top, 2));
+  wc_space_saving_offer_top(&ss, &top);
+  wc_topk_sort(&top);
+  ASSERT(0 == strcmp("w0", (const char *) top.heap[0].word));
+  ASSERT(50 == top.heap[0].count && 0 == top.heap[0].error);
+  ASSERT(0 == strcmp("w5", (const char *) top.heap[1].word));
+  ASSERT(10 == top.heap[1].count && 0 == top.heap[1].error);
+  wc_topk_free(&top);
+  wc_space_saving_free(&ss);
+
+  // a skewed stream with many more words than counters: compare against
+  // the exact counts
+  struct WcDict *exact = wc_dict_create();
+  uint32_t total = 0;
+  ASSERT(wc_space_saving_init(&ss, 64));
+  srand(99);
+  for (int i = 0; i < 50000; i++) {
+    // about half of the words are w0..w4, the rest spread over 5000 words
+    int r = rand() % 10000;
+    sprintf((char *) word, "w%d", r < 5000 ? r % 5 : r);
+    wc_space_saving_add(&ss, word);
+    wc_dict_intern(exact, word)->count++;
+    total++;
+  }
+  ASSERT(64 == ss.size);
+  uint64_t sum = 0;
+  for (uint32_t c = 0; c < ss.size; c++) {
+    // every estimate is an overestimate by at most its error
+    const struct WcSpaceSavingCounter *counter = &ss.counters[c];
+    struct WcDictSlot *slot = wc_dict_find(exact, counter->word);
+    ASSERT(slot != NULL);
+    ASSERT(counter->count >= slot->count);
+    ASSERT(counter->count - counter->error <= slot->count);
+    ASSERT(counter->error <= total / ss.capacity);
+    sum += counter->count;
+  }
+  // the counts add up to the number of words
+  ASSERT(total == sum);
+  // the heavy hitters are all found
+  ASSERT(wc_topk_init(&top, 5));
+  wc_space_saving_offer_top(&ss, &top);
+  ASSERT(5 == wc_topk_sort(&top));
+  for (int i = 0; i < 5; i++) {
+    ASSERT('w' == top.heap[i].word[0] && top.heap[i].word[1] >= '0' && top.heap[i].word[1] <= '4');
+    ASSERT('\0' == top.heap[i].word[2]);
+  }
+  wc_topk_free(&top);
+  // every monitored word can still be found through the index after
+  // all of the evictions, so adding it again just counts it
+  uint32_t counts[64];
+  for (uint32_t c = 0; c < ss.size; c++) {
+    counts[c] = ss.counters[c].count;
+  }
+  for (uint32_t c = 0; c < ss.size; c++) {
+    strcpy((char *) word, (const char *) ss.counters[c].word);
+    wc_space_saving_add(&ss, word);
+    ASSERT(counts[c] + 1 == ss.counters[c].count);
+    ASSERT(0 == strcmp((const char *) word, (const char *) ss.counters[c].word));
+  }
+  wc_space_saving_free(&ss);
+  wc_dict_destroy(exact);
+}
+
+void test_top_tracker(TestObjs *objs) {
+  struct WcTopTracker tracker;
+  struct WcTopK top;
+  unsigned char word[MAX_WORDLEN + 1];
+
+  // counting words one at a time keeps the same top words that a scan
+  // of the final counts finds
+  struct WcDict *d = wc_dict_create();
+  ASSERT(wc_top_tracker_init(&tracker, 5));
+  srand(7);
+  for (int i = 0; i < 20000; i++) {
+    // skewed, so that the top words keep changing places early on
+    int r = rand() % 1000;
+    sprintf((char *) word, "w%d", r < 600 ? r % 8 : r);
+    struct WcDictSlot *slot = wc_dict_intern(d, word);
+    slot->count++;
+    wc_top_tracker_update(&tracker, slot->word, slot->count);
+    if (i == 0) {
+      ASSERT(1 == tracker.size);
+      ASSERT(1 == tracker.entries[0].count);
+    }
+  }
+  ASSERT(5 == tracker.size);
+  ASSERT(wc_topk_init(&top, 5));
+  wc_topk_offer_dict(&top, d);
+  ASSERT(5 == wc_topk_sort(&top));
+  for (int i = 0; i < 5; i++) {
+    ASSERT(top.heap[i].word == tracker.entries[i].word);
+    ASSERT(top.heap[i].count == tracker.entries[i].count);
+  }
+  wc_topk_free(&top);
+  wc_top_tracker_free(&tracker);
+
+  // ties go to the lexicographically smaller word, and a word already in
+  // the list isn't added twice
+  ASSERT(wc_top_tracker_init(&tracker, 2));
+  wc_top_tracker_update(&tracker, objs->test_str_1, 1);
+  wc_top_tracker_update(&tracker, objs->test_str_4, 1);
+  wc_top_tracker_update(&tracker, objs->test_str_3, 1);
+  ASSERT(2 == tracker.size);
+  ASSERT(objs->test_str_3 == tracker.entries[0].word);
+  ASSERT(objs->test_str_1 == tracker.entries[1].word);
+  wc_top_tracker_update(&tracker, objs->test_str_1, 2);
+  ASSERT(2 == tracker.size);
+  ASSERT(objs->test_str_1 == tracker.entries[0].word && 2 == tracker.entries[0].count);
+  ASSERT(objs->test_str_3 == tracker.entries[1].word);
+  // a word that was pushed out gets back in once it is better
+  wc_top_tracker_update(&tracker, objs->test_str_4, 2);
+  ASSERT(objs->test_str_1 == tracker.entries[0].word);
+  ASSERT(objs->test_str_4 == tracker.entries[1].word && 2 == tracker.entries[1].count);
+  wc_top_tracker_free(&tracker);
+  wc_dict_destroy(d);
+}
+
+void test_index(TestObjs *objs) {
+  char names[2][32];
+  unsigned char word[MAX_WORDLEN + 1];
+  struct WcIndexReader *r;
+  int status;
+
+  // two dictionaries with some words in common, each written to an index
+  struct WcDict *dicts[2] = { wc_dict_create(), wc_dict_create() };
+  for (int i = 0; i < 300; i++) {
+    sprintf((char *) word, "word%d", i);
+    wc_dict_intern(dicts[0], word)->count += i + 1;
+    sprintf((char *) word, "word%d", i + 200);
+    wc_dict_intern(dicts[1], word)->count += 1;
+  }
+  wc_dict_intern(dicts[1], objs->test_str_1)->count = 5;
+  wc_dict_intern(dicts[1], (const unsigned char *) "")->count = 2;
+  wc_dict_intern(dicts[1], (const unsigned char *) "caf\xc3\xa9")->count = 1;
+  for (int f = 0; f < 2; f++) {
+    strcpy(names[f], "/tmp/wctestsXXXXXX");
+    int fd = mkstemp(names[f]);
+    ASSERT(fd >= 0);
+    close(fd);
+    ASSERT(wc_index_write_dicts(names[f], &dicts[f], 1));
+  }
+
+  // reading an index gives back every word with its count, in order
+  r = wc_index_reader_open(names[1]);
+  ASSERT(r != NULL);
+  ASSERT(303 == r->unique_words);
+  ASSERT(308 == r->total_words);
+  ASSERT(1 == wc_index_reader_next(r));
+  ASSERT(0 == strcmp("", (const char *) r->word) && 2 == r->count);
+  ASSERT(1 == wc_index_reader_next(r));
+  ASSERT(0 == strcmp("caf\xc3\xa9", (const char *) r->word) && 1 == r->count);
+  ASSERT(1 == wc_index_reader_next(r));
+  ASSERT(0 == strcmp("hello", (const char *) r->word) && 5 == r->count);
+  ASSERT(1 == wc_index_reader_next(r));
+  ASSERT(0 == strcmp("word200", (const char *) r->word) && 1 == r->count);
+  int n = 4;
+  while ((status = wc_index_reader_next(r)) == 1) {
+    n++;
+  }
+  ASSERT(0 == status);
+  ASSERT(303 == n);
+  wc_index_reader_close(r);
+
+  // merging the two indexes adds up the counts of the common words
+  struct WcIndexReader *inputs[2];
+  struct WcIndexMerge merge;
+  for (int f = 0; f < 2; f++) {
+    inputs[f] = wc_index_reader_open(names[f]);
+    ASSERT(inputs[f] != NULL);
+  }
+  ASSERT(1 == wc_index_merge_init(&merge, inputs, 2));
+  uint64_t total = 0, unique = 0;
+  while ((status = wc_index_merge_next(&merge)) == 1) {
+    struct WcDictSlot *a = wc_dict_find(dicts[0], merge.word);
+    struct WcDictSlot *b = wc_dict_find(dicts[1], merge.word);
+    ASSERT(a != NULL || b != NULL);
+    ASSERT(merge.count == (a != NULL ? a->count : 0) + (b != NULL ? b->count : 0));
+    total += merge.count;
+    unique++;
+  }
+  ASSERT(0 == status);
+  ASSERT(503 == unique);
+  ASSERT(300 * 301 / 2 + 308 == total);
+  wc_index_merge_free(&merge);
+  for (int f = 0; f < 2; f++) {
+    wc_index_reader_close(inputs[f]);
+  }
+
+  // a writer refuses words out of order
+  struct WcIndexWriter writer;
+  FILE *out = tmpfile();
+  ASSERT(wc_index_writer_init(&writer, out));
+  ASSERT(wc_index_writer_add(&writer, objs->test_str_1, 1));
+  ASSERT(!wc_index_writer_add(&writer, objs->test_str_1, 1));
+  ASSERT(!wc_index_writer_finish(&writer));
+  fclose(out);
+
+  // a truncated file is reported as corrupt
+  struct stat st;
+  ASSERT(0 == stat(names[1], &st));
+  ASSERT(0 == truncate(names[1], st.st_size - 3));
+  r = wc_index_reader_open(names[1]);
+  ASSERT(r != NULL);
+  while ((status = wc_index_reader_next(r)) == 1) {
+  }
+  ASSERT(-1 == status);
+  wc_index_reader_close(r);
+  // and a file that isn't an index isn't opened
+  FILE *text = create_input_file(objs->test_str_2);
+  ASSERT(NULL == wc_index_reader_open_fd(fileno(text)));
+  fclose(text);
+
+  for (int f = 0; f < 2; f++) {
+    unlink(names[f]);
+    wc_dict_destroy(dicts[f]);
+  }
+}
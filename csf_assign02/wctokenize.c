@@ -0,0 +1,178 @@
+// SIMD tokenizer: C implementation of wc_tokenize. (The assembly
+// implementation is in asm_wcfuncs.S.)
+
+#include <stdint.h>
+#include <stddef.h>
+#include "wcfuncs.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define WC_HAVE_X86_SIMD 1
+#endif
+
+// Classify the 64 bytes at p, returning a mask with bit i set if p[i] is
+// not whitespace, and (if lower isn't NULL) store the bytes at lower with
+// 'A'-'Z' lowercased.
+typedef uint64_t (*ClassifyFn)(const unsigned char *p, unsigned char *lower);
+
+// 1 if c is not one of the whitespace characters recognized by wc_isspace
+static inline int wc_is_word_byte(unsigned char c) {
+  // '\t', '\n', '\v', '\f' and '\r' are 9 through 13
+  return c != ' ' && (unsigned char) (c - 9) > 4;
+}
+
+static inline unsigned char wc_lower_byte(unsigned char c) {
+  return (unsigned char) (c + (((unsigned char) (c - 'A') <= 25) << 5));
+}
+
+#if !defined(WC_HAVE_X86_SIMD)
+
+static uint64_t classify64_scalar(const unsigned char *p, unsigned char *lower) {
+  uint64_t mask = 0;
+  for (int i = 0; i < 64; i++) {
+    mask |= (uint64_t) wc_is_word_byte(p[i]) << i;
+    if (lower != NULL) {
+      lower[i] = wc_lower_byte(p[i]);
+    }
+  }
+  return mask;
+}
+
+#else
+
+// SSE2 is part of x86-64, so this version needs no CPU check. Unsigned
+// byte range checks are done as min(x, limit) == x.
+static uint64_t classify64_sse2(const unsigned char *p, unsigned char *lower) {
+  const __m128i spaces = _mm_set1_epi8(' ');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i four = _mm_set1_epi8(4);
+  const __m128i upper_a = _mm_set1_epi8('A');
+  const __m128i twenty_five = _mm_set1_epi8(25);
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  uint64_t ws = 0;
+  for (int k = 0; k < 4; k++) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (p + 16 * k));
+    __m128i ctrl = _mm_sub_epi8(v, nine);
+    __m128i is_ws = _mm_or_si128(_mm_cmpeq_epi8(v, spaces),
+                                 _mm_cmpeq_epi8(_mm_min_epu8(ctrl, four), ctrl));
+    ws |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_ws) << (16 * k);
+    if (lower != NULL) {
+      __m128i alpha = _mm_sub_epi8(v, upper_a);
+      __m128i is_upper = _mm_cmpeq_epi8(_mm_min_epu8(alpha, twenty_five), alpha);
+      _mm_storeu_si128((__m128i *) (lower + 16 * k), _mm_add_epi8(v, _mm_and_si128(is_upper, case_bit)));
+    }
+  }
+  return ~ws;
+}
+
+__attribute__((target("avx2")))
+static uint64_t classify64_avx2(const unsigned char *p, unsigned char *lower) {
+  const __m256i spaces = _mm256_set1_epi8(' ');
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i four = _mm256_set1_epi8(4);
+  const __m256i upper_a = _mm256_set1_epi8('A');
+  const __m256i twenty_five = _mm256_set1_epi8(25);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  uint64_t ws = 0;
+  for (int k = 0; k < 2; k++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (p + 32 * k));
+    __m256i ctrl = _mm256_sub_epi8(v, nine);
+    __m256i is_ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, spaces),
+                                    _mm256_cmpeq_epi8(_mm256_min_epu8(ctrl, four), ctrl));
+    ws |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_ws) << (32 * k);
+    if (lower != NULL) {
+      __m256i alpha = _mm256_sub_epi8(v, upper_a);
+      __m256i is_upper = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, twenty_five), alpha);
+      _mm256_storeu_si256((__m256i *) (lower + 32 * k), _mm256_add_epi8(v, _mm256_and_si256(is_upper, case_bit)));
+    }
+  }
+  // gcc only adds this itself when optimizing; without it, the SSE code
+  // run next stalls on the dirty upper halves of the registers
+  _mm256_zeroupper();
+  return ~ws;
+}
+
+#endif // WC_HAVE_X86_SIMD
+
+// Pick the fastest classifier the CPU supports (checked once; threads
+// racing to do the check all store the same value)
+static ClassifyFn wc_classifier(void) {
+  static ClassifyFn cached = NULL;
+  ClassifyFn classify = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+  if (classify == NULL) {
+#if defined(WC_HAVE_X86_SIMD)
+    __builtin_cpu_init();
+    classify = __builtin_cpu_supports("avx2") ? classify64_avx2 : classify64_sse2;
+#else
+    classify = classify64_scalar;
+#endif
+    __atomic_store_n(&cached, classify, __ATOMIC_RELAXED);
+  }
+  return classify;
+}
+
+uint64_t wc_tokenize(const unsigned char *buf, uint64_t len, int at_end, unsigned char *lower,
+                     struct WcSpan *spans, uint64_t max_spans, uint64_t *consumed) {
+  ClassifyFn classify = wc_classifier();
+  uint64_t n = 0;
+  uint64_t prev = 0;       // 1 if the byte before the current block is in a word
+  int in_word = 0;
+  uint64_t word_start = 0;
+
+  if (max_spans == 0) {
+    *consumed = 0;
+    return 0;
+  }
+
+  for (uint64_t base = 0; base < len; base += 64) {
+    uint64_t mask, valid = ~(uint64_t) 0;
+    if (len - base >= 64) {
+      mask = classify(buf + base, lower != NULL ? lower + base : NULL);
+    } else {
+      // partial block at the end: classify it a byte at a time
+      uint64_t count = len - base;
+      mask = 0;
+      for (uint64_t i = 0; i < count; i++) {
+        mask |= (uint64_t) wc_is_word_byte(buf[base + i]) << i;
+        if (lower != NULL) {
+          lower[base + i] = wc_lower_byte(buf[base + i]);
+        }
+      }
+      valid = ((uint64_t) 1 << count) - 1;
+    }
+
+    // a set bit marks a byte that starts or ends (is just past) a word
+    uint64_t trans = (mask ^ ((mask << 1) | prev)) & valid;
+    prev = mask >> 63;
+    while (trans != 0) {
+      uint64_t pos = base + (uint64_t) __builtin_ctzll(trans);
+      trans &= trans - 1;
+      if (!in_word) {
+        word_start = pos;
+        in_word = 1;
+      } else {
+        spans[n].offset = word_start;
+        spans[n].len = pos - word_start;
+        n++;
+        in_word = 0;
+        if (n == max_spans) {
+          *consumed = pos;
+          return n;
+        }
+      }
+    }
+  }
+
+  if (in_word) {
+    if (!at_end) {
+      // the word may continue, so leave it for the next call
+      *consumed = word_start;
+      return n;
+    }
+    spans[n].offset = word_start;
+    spans[n].len = len - word_start;
+    n++;
+  }
+  *consumed = len;
+  return n;
+}
@@ -0,0 +1,275 @@
+// Finding the most frequent words: a bounded heap of the best K words
+// (struct WcTopK), a list of the best K words kept up to date as counts
+// increase (struct WcTopTracker), and a Space-Saving sketch (struct
+// WcSpaceSaving) for streams whose vocabulary is too big to count exactly.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "wcfuncs.h"
+
+// 1 if entry a is worse than entry b: fewer occurrences, or the same
+// number and lexicographically greater
+static int wc_topk_worse(const struct WcTopEntry *a, const struct WcTopEntry *b) {
+  if (a->count != b->count) {
+    return a->count < b->count;
+  }
+  return wc_str_compare(a->word, b->word) > 0;
+}
+
+// Move entry i of the heap down until neither child is worse than it
+static void wc_topk_sift_down(struct WcTopEntry *heap, uint32_t size, uint32_t i) {
+  struct WcTopEntry e = heap[i];
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && wc_topk_worse(&heap[child + 1], &heap[child])) {
+      child++;
+    }
+    if (!wc_topk_worse(&heap[child], &e)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = e;
+}
+
+int wc_topk_init(struct WcTopK *t, uint32_t k) {
+  t->heap = malloc(k * sizeof(struct WcTopEntry));
+  t->size = 0;
+  t->k = k;
+  return t->heap != NULL;
+}
+
+void wc_topk_offer(struct WcTopK *t, const unsigned char *word, uint32_t count, uint32_t error) {
+  struct WcTopEntry e = { word, count, error };
+  if (t->k == 0) {
+    return;
+  }
+  if (t->size < t->k) {
+    // not full yet: add the entry at the bottom and move it up
+    uint32_t i = t->size++;
+    while (i > 0 && wc_topk_worse(&e, &t->heap[(i - 1) / 2])) {
+      t->heap[i] = t->heap[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    t->heap[i] = e;
+  } else if (wc_topk_worse(&t->heap[0], &e)) {
+    // better than the worst entry kept, which it replaces
+    t->heap[0] = e;
+    wc_topk_sift_down(t->heap, t->size, 0);
+  }
+}
+
+void wc_topk_offer_dict(struct WcTopK *t, const struct WcDict *d) {
+  for (uint64_t i = 0; i < d->capacity; i++) {
+    const struct WcDictSlot *slot = &d->slots[i];
+    if (slot->fingerprint != 0) {
+      wc_topk_offer(t, slot->word, slot->count, 0);
+    }
+  }
+}
+
+uint32_t wc_topk_sort(struct WcTopK *t) {
+  // heapsort: repeatedly move the worst entry to the end
+  for (uint32_t n = t->size; n > 1; n--) {
+    struct WcTopEntry worst = t->heap[0];
+    t->heap[0] = t->heap[n - 1];
+    t->heap[n - 1] = worst;
+    wc_topk_sift_down(t->heap, n - 1, 0);
+  }
+  return t->size;
+}
+
+void wc_topk_free(struct WcTopK *t) {
+  free(t->heap);
+  t->heap = NULL;
+  t->size = 0;
+}
+
+int wc_top_tracker_init(struct WcTopTracker *t, uint32_t k) {
+  t->entries = malloc(k * sizeof(struct WcTopEntry));
+  t->size = 0;
+  t->k = k;
+  return t->entries != NULL;
+}
+
+void wc_top_tracker_update(struct WcTopTracker *t, const unsigned char *word, uint32_t count) {
+  struct WcTopEntry e = { word, count, 0 };
+  if (t->k == 0) {
+    return;
+  }
+  // when full, a word that isn't better than the last entry can't be in
+  // the list (if it were, it would now be better than its own entry,
+  // and so than the last one), and doesn't get in
+  if (t->size == t->k && !wc_topk_worse(&t->entries[t->size - 1], &e)) {
+    return;
+  }
+  // find the word's entry, searching from the front where the most
+  // frequent words are; if it isn't there, it replaces the last entry
+  // (or is added, if there is room)
+  uint32_t i = 0;
+  while (i < t->size && t->entries[i].word != word) {
+    i++;
+  }
+  if (i == t->size) {
+    if (t->size < t->k) {
+      t->size++;
+    } else {
+      i--;
+    }
+  }
+  // move it ahead of the entries it is now better than
+  while (i > 0 && wc_topk_worse(&t->entries[i - 1], &e)) {
+    t->entries[i] = t->entries[i - 1];
+    i--;
+  }
+  t->entries[i] = e;
+}
+
+void wc_top_tracker_free(struct WcTopTracker *t) {
+  free(t->entries);
+  t->entries = NULL;
+  t->size = 0;
+}
+
+// Move the counter at heap position i down until no child has a smaller
+// count, keeping the counters' heap_pos up to date
+static void wc_space_saving_sift_down(struct WcSpaceSaving *ss, uint32_t i) {
+  uint32_t c = ss->heap[i];
+  uint32_t count = ss->counters[c].count;
+  for (;;) {
+    uint32_t child = 2 * i + 1;
+    if (child >= ss->size) {
+      break;
+    }
+    if (child + 1 < ss->size &&
+        ss->counters[ss->heap[child + 1]].count < ss->counters[ss->heap[child]].count) {
+      child++;
+    }
+    if (ss->counters[ss->heap[child]].count >= count) {
+      break;
+    }
+    ss->heap[i] = ss->heap[child];
+    ss->counters[ss->heap[i]].heap_pos = i;
+    i = child;
+  }
+  ss->heap[i] = c;
+  ss->counters[c].heap_pos = i;
+}
+
+// Move the counter at heap position i up until its parent's count is no
+// greater than its own, keeping the counters' heap_pos up to date
+static void wc_space_saving_sift_up(struct WcSpaceSaving *ss, uint32_t i) {
+  uint32_t c = ss->heap[i];
+  while (i > 0 && ss->counters[ss->heap[(i - 1) / 2]].count > ss->counters[c].count) {
+    ss->heap[i] = ss->heap[(i - 1) / 2];
+    ss->counters[ss->heap[i]].heap_pos = i;
+    i = (i - 1) / 2;
+  }
+  ss->heap[i] = c;
+  ss->counters[c].heap_pos = i;
+}
+
+// Index slot holding the counter for w (whose hash code is hash), or the
+// empty slot where it belongs
+static uint64_t wc_space_saving_probe(const struct WcSpaceSaving *ss, const unsigned char *w, uint32_t hash) {
+  uint64_t i = hash & ss->index_mask;
+  while (ss->index[i] != 0) {
+    const struct WcSpaceSavingCounter *c = &ss->counters[ss->index[i] - 1];
+    if (c->hash == hash && wc_str_compare(c->word, w) == 0) {
+      break;
+    }
+    i = (i + 1) & ss->index_mask;
+  }
+  return i;
+}
+
+// Remove index slot i, moving later entries of its probe sequence back
+// so that none of them becomes unreachable
+static void wc_space_saving_unindex(struct WcSpaceSaving *ss, uint64_t i) {
+  uint64_t j = i;
+  for (;;) {
+    j = (j + 1) & ss->index_mask;
+    if (ss->index[j] == 0) {
+      break;
+    }
+    uint64_t home = ss->counters[ss->index[j] - 1].hash & ss->index_mask;
+    // entry j can move to i unless its home slot is cyclically in (i, j]
+    int stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays) {
+      ss->index[i] = ss->index[j];
+      i = j;
+    }
+  }
+  ss->index[i] = 0;
+}
+
+int wc_space_saving_init(struct WcSpaceSaving *ss, uint32_t capacity) {
+  // at most half of the index is used
+  uint64_t index_size = 2;
+  while (index_size < 2 * (uint64_t) capacity) {
+    index_size *= 2;
+  }
+  ss->counters = malloc(capacity * sizeof(struct WcSpaceSavingCounter));
+  ss->heap = malloc(capacity * sizeof(uint32_t));
+  ss->index = calloc(index_size, sizeof(uint32_t));
+  ss->index_mask = index_size - 1;
+  ss->size = 0;
+  ss->capacity = capacity;
+  if (ss->counters == NULL || ss->heap == NULL || ss->index == NULL) {
+    wc_space_saving_free(ss);
+    return 0;
+  }
+  return 1;
+}
+
+void wc_space_saving_add(struct WcSpaceSaving *ss, const unsigned char *w) {
+  uint32_t hash = wc_hash(w);
+  uint64_t slot = wc_space_saving_probe(ss, w, hash);
+  uint32_t c;
+  if (ss->index[slot] != 0) {
+    // already monitored: just count it
+    c = ss->index[slot] - 1;
+    ss->counters[c].count++;
+    wc_space_saving_sift_down(ss, ss->counters[c].heap_pos);
+    return;
+  }
+  if (ss->size < ss->capacity) {
+    // a free counter, starting at the bottom of the heap
+    c = ss->size++;
+    ss->counters[c].count = 1;
+    ss->counters[c].error = 0;
+    ss->heap[c] = c;
+    wc_space_saving_sift_up(ss, c);
+  } else {
+    // take over the counter with the smallest count
+    c = ss->heap[0];
+    wc_space_saving_unindex(ss, wc_space_saving_probe(ss, ss->counters[c].word, ss->counters[c].hash));
+    ss->counters[c].error = ss->counters[c].count;
+    ss->counters[c].count++;
+    slot = wc_space_saving_probe(ss, w, hash);
+  }
+  wc_str_copy(ss->counters[c].word, w);
+  ss->counters[c].hash = hash;
+  ss->index[slot] = c + 1;
+  wc_space_saving_sift_down(ss, ss->counters[c].heap_pos);
+}
+
+void wc_space_saving_offer_top(const struct WcSpaceSaving *ss, struct WcTopK *t) {
+  for (uint32_t c = 0; c < ss->size; c++) {
+    wc_topk_offer(t, ss->counters[c].word, ss->counters[c].count, ss->counters[c].error);
+  }
+}
+
+void wc_space_saving_free(struct WcSpaceSaving *ss) {
+  free(ss->counters);
+  free(ss->heap);
+  free(ss->index);
+  ss->counters = NULL;
+  ss->heap = NULL;
+  ss->index = NULL;
+  ss->size = 0;
+}
@@ -0,0 +1,168 @@
+// csimbench: simulation rate (accesses per second) of the map-based Cache
+// and the FlatCache on generated traces, checking that both give the same
+// results.
+//
+//   csimbench [-n ACCESSES] [--seed N]
+//
+// Each trace has ACCESSES loads and stores (two loads for every store) of
+// 4-byte words. A "hit-heavy" trace picks its addresses at random from a
+// region half the size of the cache, so after warming up nearly every
+// access hits; a "miss-heavy" one picks them from a region 64 times the
+// size of the cache, so nearly every access misses. The traces are
+// generated in memory, so only the simulation itself is timed.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "csimfuncs.h"
+
+// one memory access of a trace
+struct Access {
+    uint32_t address;
+    bool store;
+};
+
+// cache parameters, as given to csim
+struct Geometry {
+    int sets, blocks, bytes;
+};
+
+// counts reported by a simulation
+struct Counts {
+    long load_hits, load_misses, store_hits, store_misses, total_cycles;
+};
+
+// cache geometries benchmarked: direct mapped, set associative with few
+// and many ways, and fully associative
+static const Geometry geometries[] = {
+    { 4096, 1, 16 },
+    { 256, 4, 16 },
+    { 64, 16, 16 },
+    { 16, 64, 16 },
+    { 1, 1024, 16 },
+};
+
+// xorshift64* generator, so that a seed always gives the same traces
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+static std::vector<Access> generateTrace(size_t numAccesses, uint64_t regionBytes, uint64_t seed) {
+    std::vector<Access> trace(numAccesses);
+    uint64_t state = seed * 0x9e3779b97f4a7c15ULL + 1;
+    for (size_t i = 0; i < numAccesses; i++) {
+        uint64_t r = nextRandom(state);
+        trace[i].address = (uint32_t) ((r >> 8) % (regionBytes / 4) * 4);
+        trace[i].store = r % 3 == 0;
+    }
+    return trace;
+}
+
+// the engines, behind the same names so one simulate() drives either
+static int load(Cache& cache, uint32_t index, uint32_t tag, int bytes) {
+    return cacheLoad(cache, index, tag, bytes, false, true);
+}
+
+static int load(FlatCache& cache, uint32_t index, uint32_t tag, int bytes) {
+    return flatCacheLoad(cache, index, tag, bytes, false, true);
+}
+
+static int store(Cache& cache, uint32_t index, uint32_t tag, int bytes, bool* hit) {
+    return cacheStore(cache, index, tag, bytes, true, false, true, hit);
+}
+
+static int store(FlatCache& cache, uint32_t index, uint32_t tag, int bytes, bool* hit) {
+    return flatCacheStore(cache, index, tag, bytes, true, false, true, hit);
+}
+
+// run the trace through the cache (write-allocate, write-back, lru) the
+// way csim does, storing the time taken in seconds
+template <typename CacheType>
+static Counts simulate(CacheType& cache, const std::vector<Access>& trace, const Geometry& g, double* seconds) {
+    Counts counts = { 0, 0, 0, 0, 0 };
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.size(); i++) {
+        uint32_t tag = getTag(g.bytes, trace[i].address, g.sets);
+        uint32_t index = getIndex(g.bytes, trace[i].address, g.sets);
+        if (!trace[i].store) {
+            int cycles = load(cache, index, tag, g.bytes);
+            if (cycles == 1) {
+                counts.load_hits++;
+            }
+            else {
+                counts.load_misses++;
+            }
+            counts.total_cycles += cycles;
+        }
+        else {
+            bool hit = false;
+            counts.total_cycles += store(cache, index, tag, g.bytes, &hit);
+            if (hit) {
+                counts.store_hits++;
+            }
+            else {
+                counts.store_misses++;
+            }
+        }
+    }
+    *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return counts;
+}
+
+static bool sameCounts(const Counts& a, const Counts& b) {
+    return a.load_hits == b.load_hits && a.load_misses == b.load_misses && a.store_hits == b.store_hits
+        && a.store_misses == b.store_misses && a.total_cycles == b.total_cycles;
+}
+
+int main(int argc, char** argv) {
+    long numAccesses = 2000000;
+    long seed = 1;
+    for (int arg = 1; arg < argc; arg += 2) {
+        char* end = nullptr;
+        long value = arg + 1 < argc ? strtol(argv[arg + 1], &end, 10) : 0;
+        bool valid = end != nullptr && *end == '\0' && value > 0;
+        if (valid && strcmp(argv[arg], "-n") == 0) {
+            numAccesses = value;
+        }
+        else if (valid && strcmp(argv[arg], "--seed") == 0) {
+            seed = value;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [-n ACCESSES] [--seed N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%-14s %-11s %8s %14s %14s %8s\n", "cache", "trace", "hit rate", "map (acc/s)", "flat (acc/s)", "speedup");
+    for (const Geometry& g : geometries) {
+        uint64_t cacheBytes = (uint64_t) g.sets * g.blocks * g.bytes;
+        const char* names[] = { "hit-heavy", "miss-heavy" };
+        uint64_t regions[] = { cacheBytes / 2, cacheBytes * 64 };
+        for (int t = 0; t < 2; t++) {
+            std::vector<Access> trace = generateTrace((size_t) numAccesses, regions[t], (uint64_t) seed + t);
+            double mapSeconds, flatSeconds;
+            Cache cache = initializeCache(g.sets, g.blocks);
+            Counts mapCounts = simulate(cache, trace, g, &mapSeconds);
+            FlatCache flatCache = initializeFlatCache(g.sets, g.blocks);
+            Counts flatCounts = simulate(flatCache, trace, g, &flatSeconds);
+            if (!sameCounts(mapCounts, flatCounts)) {
+                std::cerr << "Engines disagree for " << g.sets << " " << g.blocks << " " << g.bytes
+                          << " on the " << names[t] << " trace" << std::endl;
+                return 1;
+            }
+            std::string geometry = std::to_string(g.sets) + " " + std::to_string(g.blocks) + " " + std::to_string(g.bytes);
+            double hitRate = (double) (mapCounts.load_hits + mapCounts.store_hits) / numAccesses;
+            std::printf("%-14s %-11s %7.1f%% %14.0f %14.0f %7.2fx\n", geometry.c_str(), names[t], 100 * hitRate,
+                        numAccesses / mapSeconds, numAccesses / flatSeconds, mapSeconds / flatSeconds);
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <vector>
+#include "csimfuncs.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define CSIM_HAVE_X86_SIMD 1
+#endif
+
+// check the ways one at a time (for sets too small for a vector)
+static int findWayScalar(const uint32_t* setTags, int ways, uint32_t tag) {
+    for (int i = 0; i < ways; i++) {
+        if (setTags[i] == tag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef CSIM_HAVE_X86_SIMD
+
+// compare 4 tags at a time; SSE2 is part of x86-64 so this needs no CPU check
+// (ways must be a multiple of 4)
+static int findWaySse2(const uint32_t* setTags, int ways, uint32_t tag) {
+    __m128i key = _mm_set1_epi32((int) tag);
+    for (int i = 0; i < ways; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (setTags + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+        // lowest matching way first, like the scalar search
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return -1;
+}
+
+// compare 8 tags at a time (ways must be a multiple of 8); big sets are
+// checked 32 tags per branch
+__attribute__((target("avx2")))
+static int findWayAvx2(const uint32_t* setTags, int ways, uint32_t tag) {
+    __m256i key = _mm256_set1_epi32((int) tag);
+    int way = -1;
+    int i = 0;
+    for (; way == -1 && i + 32 <= ways; i += 32) {
+        __m256i eq0 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (setTags + i)), key);
+        __m256i eq1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (setTags + i + 8)), key);
+        __m256i eq2 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (setTags + i + 16)), key);
+        __m256i eq3 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (setTags + i + 24)), key);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(eq0, eq1), _mm256_or_si256(eq2, eq3));
+        if (!_mm256_testz_si256(any, any)) {
+            // found in this group of 32: find which of the 4 vectors has it
+            uint32_t mask = (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(eq0))
+                | (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(eq1)) << 8
+                | (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(eq2)) << 16
+                | (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(eq3)) << 24;
+            way = i + __builtin_ctz(mask);
+        }
+    }
+    for (; way == -1 && i < ways; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (setTags + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        if (mask != 0) {
+            way = i + __builtin_ctz(mask);
+        }
+    }
+    // the rest of the simulation loop is non-VEX code, which would pay an
+    // AVX to SSE transition on every access if the upper halves stayed dirty
+    _mm256_zeroupper();
+    return way;
+}
+
+#endif // CSIM_HAVE_X86_SIMD
+
+FlatCache initializeFlatCache(int numSets, int numSlotsPerSet) {
+    FlatCache cache;
+    size_t numSlots = (size_t) numSets * numSlotsPerSet;
+    cache.ways = numSlotsPerSet;
+    // every slot starts out invalid, clean and with zero timestamps
+    cache.tags.assign(numSlots, INVALID_TAG);
+    cache.dirty.assign(numSlots, 0);
+    cache.load_ts.assign(numSlots, 0);
+    cache.access_ts.assign(numSlots, 0);
+    cache.counter = 0;
+    // ways is a power of 2, so a set is a whole number of vectors once it
+    // has at least as many ways as a vector has lanes
+    cache.findWay = findWayScalar;
+#ifdef CSIM_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (numSlotsPerSet >= 8 && __builtin_cpu_supports("avx2")) {
+        cache.findWay = findWayAvx2;
+    }
+    else if (numSlotsPerSet >= 4) {
+        cache.findWay = findWaySse2;
+    }
+#endif
+    return cache;
+}
+
+int flatFindWay(const FlatCache& cache, uint32_t index, uint32_t tag) {
+    return cache.findWay(&cache.tags[(size_t) index * cache.ways], cache.ways, tag);
+}
+
+// find the way to fill after a miss in a set: the first invalid slot, or
+// else the one picked by the eviction policy
+static int flatFindSlotToFill(const FlatCache& cache, uint32_t index, bool lru) {
+    size_t base = (size_t) index * cache.ways;
+    int way = cache.findWay(&cache.tags[base], cache.ways, INVALID_TAG);
+    if (way != -1) {
+        return way;
+    }
+    // evict the slot with the smallest access_ts (lru) or load_ts (fifo),
+    // the first one if several are equal
+    const uint32_t* ts = lru ? &cache.access_ts[base] : &cache.load_ts[base];
+    way = 0;
+    for (int i = 1; i < cache.ways; ++i) {
+        if (ts[i] < ts[way]) {
+            way = i;
+        }
+    }
+    return way;
+}
+
+// put tag in a slot after a miss, updating its timestamps and dirty bit
+static void flatFillSlot(FlatCache& cache, size_t slot, uint32_t tag, bool dirty) {
+    cache.tags[slot] = tag;
+    cache.counter++;
+    cache.access_ts[slot] = cache.counter;
+    cache.load_ts[slot] = cache.counter;
+    cache.dirty[slot] = dirty;
+}
+
+int flatCacheLoad(FlatCache& cache, uint32_t index, uint32_t tag, int data_size, bool write_through, bool lru) {
+    size_t base = (size_t) index * cache.ways;
+    int way = cache.findWay(&cache.tags[base], cache.ways, tag);
+    if (way != -1) {
+        cache.counter++;
+        cache.access_ts[base + way] = cache.counter;
+        return 1;
+    }
+    int cycles = 0;
+    size_t slot = base + flatFindSlotToFill(cache, index, lru);
+    // if write_back and dirty, need to write to memory
+    if (cache.dirty[slot] && !write_through) {
+        cycles += 100*(data_size/4);
+    }
+    flatFillSlot(cache, slot, tag, false);
+    // load miss so we have 100 cycles per 4 bytes we had to load from main memory
+    cycles += 100*(data_size/4);
+    return cycles;
+}
+
+int flatCacheStore(FlatCache& cache, uint32_t index, uint32_t tag, int data_size, bool write_allocate, bool write_through, bool lru, bool* hit) {
+    size_t base = (size_t) index * cache.ways;
+    int way = cache.findWay(&cache.tags[base], cache.ways, tag);
+    if (way != -1) {
+        *hit = true;
+        cache.counter++;
+        cache.access_ts[base + way] = cache.counter;
+        if (write_through) {
+            // store to memory is 100 cycles
+            return 100;
+        }
+        // set dirty bit and return one cycle as only cache used
+        cache.dirty[base + way] = 1;
+        return 1;
+    }
+    if (!write_allocate) {
+        // for no-write-allocate and write-through, we just store to memory
+        return 100;
+    }
+    int cycles;
+    size_t slot = base + flatFindSlotToFill(cache, index, lru);
+    if (write_through) {
+        cycles = 100+(100*(data_size/4));
+    }
+    // if evicting dirty block, then more cycles than if not dirty block
+    else if (cache.dirty[slot]) {
+        cycles = 2*(100*(data_size/4));
+    }
+    else {
+        cycles = 100*(data_size/4);
+    }
+    // the new block is only dirty if write_back
+    flatFillSlot(cache, slot, tag, !write_through);
+    return cycles;
+}
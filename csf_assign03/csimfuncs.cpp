@@ -152,58 +152,75 @@ Cache initializeCache(int numSets, int numSlotsPerSet) {
     return cache;
 }
 
+int findSlotIndex(Set& cacheSet, uint32_t tag) {
+    // find() rather than at(), so that a miss is an ordinary return value
+    // instead of a thrown exception
+    std::map<uint32_t, Slot*>::iterator it = cacheSet.tagMap.find(tag);
+    if (it == cacheSet.tagMap.end()) {
+        return -1;
+    }
+    return (int) (it->second - cacheSet.slots.data());
+}
+
+int findSlotToFill(Set& cacheSet, bool lru) {
+    int slotToUpdate = findAvailableSlotIndex(cacheSet);
+    // if no available slots can be used to handle miss, then we need to evict based on eviction policy
+    if (slotToUpdate == -1) {
+        slotToUpdate = findReplacementIndex(cacheSet, lru);
+        // update map due to eviction
+        cacheSet.tagMap.erase(cacheSet.slots[slotToUpdate].tag);
+    }
+    return slotToUpdate;
+}
+
 int cacheLoad(Cache& cache, uint32_t index, uint32_t tag, int data_size, bool write_through, bool lru) {
     Set& cacheSet = cache.sets[index];
-    try {
-        Slot& slot = *cacheSet.tagMap.at(tag);
-        cache.counter++;
-        slot.access_ts = cache.counter;
-        return 1;
-    } catch (const std::out_of_range&) {
-        // Determine which cache slot to use for miss 
-        int cycles = 0, slotToUpdate = 0;
-        slotToUpdate = findAvailableSlotIndex(cacheSet);
-        // if no available slots can be used to handle miss, then we need to evict based on eviction policy
-        if (slotToUpdate == -1) {
-            slotToUpdate = findReplacementIndex(cacheSet, lru);
-            // update map due to eviction
-            cacheSet.tagMap.erase(cacheSet.slots[slotToUpdate].tag);
-        }
-        // Replace the cache slot with the new data
-        Slot& updateSlot = cacheSet.slots[slotToUpdate];
-        // if write_back and dirty, need to write to memory 
-        if (updateSlot.dirty && !write_through) {
-            cycles += 100*(data_size/4);
-        }
-        // update appropriate parameters
-        updateSlotParameters(cache, cacheSet, updateSlot, tag, write_through, true);
-        // load miss so we have 100 cycles per 4 bytes we had to load from main memory
-        cycles += 100*(data_size/4);
-        return cycles;
+    int slotIndex = findSlotIndex(cacheSet, tag);
+    if (slotIndex == -1) {
+        return handleLoadMiss(cache, cacheSet, tag, data_size, write_through, lru);
     }
+    // cache hit
+    cache.counter++;
+    cacheSet.slots[slotIndex].access_ts = cache.counter;
+    return 1;
 }
 
 int cacheStore(Cache& cache, uint32_t index, uint32_t tag, int data_size, bool write_allocate, bool write_through, bool lru, bool* hit) {
     Set& cacheSet = cache.sets[index];
     // check if we have a hit
-    try {
-        Slot& slot = *cacheSet.tagMap.at(tag);
-        // Cache hit
-        *hit = true;
-        cache.counter++;
-        slot.access_ts = cache.counter;
-        if (write_through) {
-            // store to memory is 100 cycles
-            return 100;
-        }
-        else {
-            // set dirty bit and return one cycle as only cache used
-            slot.dirty = true;
-            return 1;
-        }
-    } catch (const std::out_of_range&) {
+    int slotIndex = findSlotIndex(cacheSet, tag);
+    if (slotIndex == -1) {
         return handleStoreMiss(cache, cacheSet, tag, data_size, write_allocate, write_through, lru);
     }
+    // Cache hit
+    Slot& slot = cacheSet.slots[slotIndex];
+    *hit = true;
+    cache.counter++;
+    slot.access_ts = cache.counter;
+    if (write_through) {
+        // store to memory is 100 cycles
+        return 100;
+    }
+    else {
+        // set dirty bit and return one cycle as only cache used
+        slot.dirty = true;
+        return 1;
+    }
+}
+
+int handleLoadMiss(Cache& cache, Set& cacheSet, uint32_t tag, int data_size, bool write_through, bool lru) {
+    int cycles = 0;
+    // Replace the cache slot with the new data
+    Slot& updateSlot = cacheSet.slots[findSlotToFill(cacheSet, lru)];
+    // if write_back and dirty, need to write to memory 
+    if (updateSlot.dirty && !write_through) {
+        cycles += 100*(data_size/4);
+    }
+    // update appropriate parameters
+    updateSlotParameters(cache, cacheSet, updateSlot, tag, write_through, true);
+    // load miss so we have 100 cycles per 4 bytes we had to load from main memory
+    cycles += 100*(data_size/4);
+    return cycles;
 }
 
 int handleStoreMiss(Cache& cache, Set& cacheSet, uint32_t tag, int data_size, bool write_allocate, bool write_through, bool lru) {
@@ -211,17 +228,9 @@ int handleStoreMiss(Cache& cache, Set& cacheSet, uint32_t tag, int data_size, bo
         // for no-write-allocate and write-through, we just store to memory
         return 100;
     }
-    int cycles = 0, slotToUpdate = 0;
-    // Determine which cache slot to use for miss 
-    slotToUpdate = findAvailableSlotIndex(cacheSet);
-    // if no available slots can be used to handle miss, then we need to evict based on eviction policy
-    if (slotToUpdate == -1) {
-        slotToUpdate = findReplacementIndex(cacheSet, lru);
-        // update map due to eviction
-        cacheSet.tagMap.erase(cacheSet.slots[slotToUpdate].tag);
-    }
+    int cycles = 0;
     // update the cache slot with the new data
-    Slot& updateSlot = cacheSet.slots[slotToUpdate];
+    Slot& updateSlot = cacheSet.slots[findSlotToFill(cacheSet, lru)];
     // if write_through, we know cache is write allocate write through
     if (write_through) {
         cycles = 100+(100*(data_size/4)); 
@@ -297,4 +306,65 @@ void updateSlotParameters(Cache& cache, Set& cacheSet, Slot& updateSlot, uint32_
         }
     }
     cacheSet.tagMap[tag] = &updateSlot;
-}
\ No newline at end of file
+}
+
+CacheSim initializeCacheSim(char** argv, bool flat) {
+    CacheSim sim;
+    sim.sets = std::stoi(argv[1]);
+    sim.blocks = std::stoi(argv[2]);
+    sim.bytes = std::stoi(argv[3]);
+    sim.write_allocate = strcmp("write-allocate", argv[4]) == 0;
+    sim.write_through = strcmp("write-through", argv[5]) == 0;
+    sim.lru = strcmp(argv[6], "lru") == 0;
+    sim.flat = flat;
+    // initalize cache (only the one for the engine used)
+    if (flat) {
+        sim.flatCache = initializeFlatCache(sim.sets, sim.blocks);
+    }
+    else {
+        sim.cache = initializeCache(sim.sets, sim.blocks);
+    }
+    // initalize simulation counters to zero
+    sim.stats = CacheStats();
+    return sim;
+}
+
+void simulateAccess(CacheSim& sim, bool store, uint32_t address) {
+    // find tag 
+    uint32_t tag = getTag(sim.bytes, address, sim.sets);
+    // find index
+    uint32_t index = getIndex(sim.bytes, address, sim.sets);
+    if (!store) {
+        int cycles = sim.flat ? flatCacheLoad(sim.flatCache, index, tag, sim.bytes, sim.write_through, sim.lru)
+                              : cacheLoad(sim.cache, index, tag, sim.bytes, sim.write_through, sim.lru);
+        if (cycles == 1) {
+            sim.stats.load_hits++;
+        }
+        else {
+            sim.stats.load_misses++;
+        }
+        sim.stats.total_cycles += cycles;
+    }
+    else {
+        bool hit = false;
+        int cycles = sim.flat ? flatCacheStore(sim.flatCache, index, tag, sim.bytes, sim.write_allocate, sim.write_through, sim.lru, &hit)
+                              : cacheStore(sim.cache, index, tag, sim.bytes, sim.write_allocate, sim.write_through, sim.lru, &hit);
+        if (hit) {
+            sim.stats.store_hits++;
+        }
+        else {
+            sim.stats.store_misses++;
+        }
+        sim.stats.total_cycles += cycles;
+    }
+}
+
+void printStats(const CacheStats& stats) {
+    std::cout << "Total loads: " << (stats.load_hits+stats.load_misses) << std::endl;
+    std::cout << "Total stores: " << (stats.store_hits+stats.store_misses) << std::endl;
+    std::cout << "Load hits: " << stats.load_hits << std::endl;
+    std::cout << "Load misses: " << stats.load_misses << std::endl;
+    std::cout << "Store hits: " << stats.store_hits << std::endl;
+    std::cout << "Store misses: " << stats.store_misses << std::endl;
+    std::cout << "Total cycles: " << stats.total_cycles << std::endl;
+}
@@ -1,6 +1,8 @@
 #include <cstdint>
+#include <cstdio>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 #ifndef CSIMFUNCS_H
 #define CSIMFUNCS_H
@@ -23,6 +25,107 @@ struct Cache {
     uint32_t counter; 
 };
 
+// tag stored in a flat cache slot that holds no block (blocks are at
+// least 4 bytes, so real tags never have the top 2 bits set)
+const uint32_t INVALID_TAG = 0xFFFFFFFF;
+
+// cache with every slot's fields in flat arrays, slot `way` of set `set`
+// being element set * ways + way of each, so the tags of a set are
+// contiguous and can be compared several at a time
+struct FlatCache {
+    int ways;
+    // tag of each slot, INVALID_TAG if the slot isn't valid
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> load_ts, access_ts;
+    // global timestamp counter
+    uint32_t counter;
+    // finds the way of a set holding a tag, picked for the number of ways
+    // and the CPU by initializeFlatCache
+    int (*findWay)(const uint32_t* setTags, int ways, uint32_t tag);
+};
+
+// Binary trace files start with an 8-byte header: the magic "CSTR", a
+// version byte (TRACE_VERSION), an encoding byte and 2 zero bytes. The
+// records follow, one per access, until the end of the file:
+//   TRACE_FIXED: an op byte (0 load, 1 store) and the 4-byte address,
+//     little-endian
+//   TRACE_DELTA: a varint (7 bits per byte, low bits first, high bit set
+//     on all but the last byte) holding the zigzag-encoded difference from
+//     the previous address (0 before the first) shifted left by 1, with
+//     the low bit set for a store
+// Addresses are 32 bits, like the ones the simulator works with.
+const char TRACE_MAGIC[] = "CSTR";
+const unsigned char TRACE_VERSION = 1;
+const size_t TRACE_HEADER_SIZE = 8;
+const unsigned char TRACE_FIXED = 0;
+const unsigned char TRACE_DELTA = 1;
+
+// reads the accesses of a trace, text ("l 0x1fffff50 1" lines) or binary,
+// from a file descriptor: a regular file is mapped whole, anything else
+// is read through a buffer
+struct TraceReader {
+    int fd;
+    // bytes from pos to size are still to be parsed
+    const char* data;
+    size_t size, pos;
+    bool mapped, eof;
+    // for binary traces, the encoding and the last address read
+    bool binary;
+    unsigned char encoding;
+    uint32_t prev_address;
+    // lines (text) or records (binary) read so far, for error messages
+    uint64_t count;
+    std::vector<char> buffer;
+};
+
+// statistics of a simulation, as printed by csim
+struct CacheStats {
+    long load_hits, load_misses, store_hits, store_misses, total_cycles;
+};
+
+// a cache being simulated: its parameters, its state (in the engine
+// chosen, the other one is left empty) and its statistics so far
+struct CacheSim {
+    int sets, blocks, bytes;
+    bool write_allocate, write_through, lru, flat;
+    Cache cache;
+    FlatCache flatCache;
+    CacheStats stats;
+};
+
+// LRU stack distances of the accesses to one set of a cache. Each access
+// is numbered with the set's own time; the Fenwick tree has a 1 at every
+// time that is the last access of some tag, so the number of tags used
+// since a tag's last access (its stack distance) is a prefix sum away.
+struct StackSet {
+    // time of the last access of each tag in the set
+    std::unordered_map<uint32_t, uint32_t> last_access;
+    // tag accessed at each time (index 0 unused), for compacting the times
+    std::vector<uint32_t> tags;
+    std::vector<int> tree;
+    // time of the next access
+    uint32_t time;
+};
+
+// stack distance counts of a trace for one number of sets, from which the
+// LRU hits of every associativity up to max_ways follow
+struct StackDistances {
+    int sets, bytes, max_ways;
+    std::vector<StackSet> setStates;
+    // distance_counts[d]: accesses with d other tags used since the last
+    // access to the same tag (hits in a cache with more than d ways)
+    std::vector<uint64_t> distance_counts;
+    uint64_t accesses;
+};
+
+// writes accesses to a binary trace
+struct TraceWriter {
+    FILE* out;
+    unsigned char encoding;
+    uint32_t prev_address;
+};
+
 // check that a given number is a power of two
 bool checkPowerOfTwo(int num);
 
@@ -47,6 +150,12 @@ uint32_t getIndex(int bytes, uint32_t address, int sets);
 // initialize a cache given cache parameters
 Cache initializeCache(int numSets, int numSlots);
 
+// find the index of the slot in a set holding tag, or -1 if none does (a miss)
+int findSlotIndex(Set& cacheSet, uint32_t tag);
+
+// find the index of the slot to fill after a miss: an available slot, or else one evicted by the eviction policy
+int findSlotToFill(Set& cacheSet, bool lru);
+
 // simulate a cache load and return the total cycles taken 
 int cacheLoad(Cache& cache, uint32_t index, uint32_t tag, int data_size, bool write_through, bool lru);
 
@@ -59,10 +168,67 @@ int findReplacementIndex(Set& cacheSet, bool lru);
 // find index of available slot in a set
 int findAvailableSlotIndex(Set& cacheSet);
 
+// handle the case when a load misses in a cache
+int handleLoadMiss(Cache& cache, Set& cacheSet, uint32_t tag, int data_size, bool write_through, bool lru);
+
 // handle the case when a store misses in a cache
 int handleStoreMiss(Cache& cache, Set& cacheSet, uint32_t tag, int data_size, bool write_allocate, bool write_through, bool lru);
 
 // handles updating slot parameters after a miss
 void updateSlotParameters(Cache& cache, Set& cacheSet, Slot& updateSlot, uint32_t tag, bool write_through, bool load);
 
+// initialize a flat cache given cache parameters
+FlatCache initializeFlatCache(int numSets, int numSlotsPerSet);
+
+// find the way of a set in a flat cache holding tag, or -1 if none does
+int flatFindWay(const FlatCache& cache, uint32_t index, uint32_t tag);
+
+// simulate a load in a flat cache and return the total cycles taken (same results as cacheLoad)
+int flatCacheLoad(FlatCache& cache, uint32_t index, uint32_t tag, int data_size, bool write_through, bool lru);
+
+// simulate a store in a flat cache and return the total cycles taken (same results as cacheStore)
+int flatCacheStore(FlatCache& cache, uint32_t index, uint32_t tag, int data_size, bool write_allocate, bool write_through, bool lru, bool* hit);
+
+// set up a simulation from cache parameters already checked by validParameters
+CacheSim initializeCacheSim(char** argv, bool flat);
+
+// simulate one load or store of the trace, adding it to the statistics
+void simulateAccess(CacheSim& sim, bool store, uint32_t address);
+
+// print the statistics of a simulation
+void printStats(const CacheStats& stats);
+
+// read the configurations of a sweep from a file, one line of cache parameters (as given to csim) each; returns false if one is invalid
+bool readSweepConfigs(const char* filename, bool flat, std::vector<CacheSim>& sims);
+
+// simulate every configuration of a sweep over a single read of the trace, spread over the given number of threads; returns the status of nextAccess at the end
+int runSweep(TraceReader& reader, std::vector<CacheSim>& sims, int threads);
+
+// set up stack distance counting for a number of sets and associativities up to max_ways
+StackDistances initializeStackDistances(int sets, int bytes, int max_ways);
+
+// count the stack distance of an access (loads and stores alike, as with write-allocate)
+void recordStackDistance(StackDistances& distances, uint32_t address);
+
+// count the stack distances of every access of the trace for each number of sets; returns the status of nextAccess at the end
+int computeStackDistances(TraceReader& reader, std::vector<StackDistances>& curves);
+
+// print the LRU miss ratio of every number of sets and associativity as a table
+void printMissRatioCurves(const std::vector<StackDistances>& curves);
+
+// start reading a trace from fd, detecting whether it is binary; returns false if it can't be read
+bool openTrace(TraceReader& reader, int fd);
+
+// read the next access of a trace: returns 1 and sets store and address, 0 at the end, or -1 if the trace is malformed
+int nextAccess(TraceReader& reader, bool* store, uint32_t* address);
+
+// release what openTrace set up (the file descriptor stays open)
+void closeTrace(TraceReader& reader);
+
+// start a binary trace with the given encoding, writing its header; returns false if that fails
+bool initializeTraceWriter(TraceWriter& writer, FILE* out, unsigned char encoding);
+
+// append an access to a binary trace
+void writeAccess(TraceWriter& writer, bool store, uint32_t address);
+
 #endif // CSIMFUNCS_H
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include "csimfuncs.h"
+
+// number of times of a set kept once its live tags are compacted, at least
+static const size_t STACK_MIN_CAPACITY = 64;
+
+// sum of the Fenwick tree entries for times 1 to i
+static int fenwickSum(const std::vector<int>& tree, uint32_t i) {
+    int sum = 0;
+    for (; i > 0; i -= i & (0u - i)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+static void fenwickAdd(std::vector<int>& tree, uint32_t i, int delta) {
+    for (; i < tree.size(); i += i & (0u - i)) {
+        tree[i] += delta;
+    }
+}
+
+// once a set runs out of times, renumber the last accesses of its tags
+// 1, 2, ... (keeping their order) and make room for as many more accesses,
+// so the tree grows with the number of tags rather than of accesses
+static void compactStackSet(StackSet& set) {
+    std::vector<uint32_t> tags(1, 0);
+    tags.reserve(set.last_access.size() + 1);
+    for (uint32_t t = 1; t < set.time; t++) {
+        uint32_t& last = set.last_access[set.tags[t]];
+        if (last == t) {
+            last = (uint32_t) tags.size();
+            tags.push_back(set.tags[t]);
+        }
+    }
+    size_t live = tags.size() - 1;
+    size_t capacity = std::max(2 * live, STACK_MIN_CAPACITY);
+    tags.resize(capacity + 1);
+    set.tags.swap(tags);
+    // every renumbered time is a last access: build the tree of ones up to
+    // live in one pass, each node passing its sum on to its parent
+    set.tree.assign(capacity + 1, 0);
+    for (size_t i = 1; i <= capacity; i++) {
+        if (i <= live) {
+            set.tree[i]++;
+        }
+        size_t parent = i + (i & (0 - i));
+        if (parent <= capacity) {
+            set.tree[parent] += set.tree[i];
+        }
+    }
+    set.time = (uint32_t) live + 1;
+}
+
+StackDistances initializeStackDistances(int sets, int bytes, int max_ways) {
+    StackDistances distances;
+    distances.sets = sets;
+    distances.bytes = bytes;
+    distances.max_ways = max_ways;
+    distances.setStates.resize(sets);
+    for (StackSet& set : distances.setStates) {
+        // no room for any time yet, so the first access makes some
+        set.time = 1;
+    }
+    distances.distance_counts.assign(max_ways, 0);
+    distances.accesses = 0;
+    return distances;
+}
+
+void recordStackDistance(StackDistances& distances, uint32_t address) {
+    uint32_t tag = getTag(distances.bytes, address, distances.sets);
+    uint32_t index = getIndex(distances.bytes, address, distances.sets);
+    StackSet& set = distances.setStates[index];
+    distances.accesses++;
+    if (set.time >= set.tree.size()) {
+        compactStackSet(set);
+    }
+    std::unordered_map<uint32_t, uint32_t>::iterator it = set.last_access.find(tag);
+    if (it != set.last_access.end()) {
+        // the tags last used after this one are the ones above it in the
+        // LRU stack (a first access is a miss for every cache size)
+        uint32_t last = it->second;
+        uint64_t distance = set.last_access.size() - fenwickSum(set.tree, last);
+        if (distance < distances.distance_counts.size()) {
+            distances.distance_counts[distance]++;
+        }
+        fenwickAdd(set.tree, last, -1);
+        it->second = set.time;
+    }
+    else {
+        set.last_access[tag] = set.time;
+    }
+    set.tags[set.time] = tag;
+    fenwickAdd(set.tree, set.time, 1);
+    set.time++;
+}
+
+int computeStackDistances(TraceReader& reader, std::vector<StackDistances>& curves) {
+    bool store;
+    uint32_t address;
+    int status;
+    while ((status = nextAccess(reader, &store, &address)) > 0) {
+        for (StackDistances& distances : curves) {
+            recordStackDistance(distances, address);
+        }
+    }
+    return status;
+}
+
+void printMissRatioCurves(const std::vector<StackDistances>& curves) {
+    if (curves.empty()) {
+        return;
+    }
+    std::printf("LRU miss ratio (%%) of %d-byte blocks over %lu accesses\n", curves[0].bytes,
+                (unsigned long) curves[0].accesses);
+    std::printf("%-8s", "sets");
+    for (int ways = 1; ways <= curves[0].max_ways; ways *= 2) {
+        std::printf(" %7d", ways);
+    }
+    std::printf("   (blocks per set)\n");
+    for (const StackDistances& distances : curves) {
+        std::printf("%-8d", distances.sets);
+        // a cache with w ways hits on every access with a distance below w
+        uint64_t hits = 0;
+        int counted = 0;
+        for (int ways = 1; ways <= distances.max_ways; ways *= 2) {
+            for (; counted < ways; counted++) {
+                hits += distances.distance_counts[counted];
+            }
+            double missRatio = distances.accesses > 0 ? 100.0 * (distances.accesses - hits) / distances.accesses : 0;
+            std::printf(" %7.2f", missRatio);
+        }
+        std::printf("\n");
+    }
+}
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "csimfuncs.h"
+
+// accesses decoded at a time: each configuration runs through a whole chunk
+// before moving on, so its cache stays in the CPU cache meanwhile
+static const size_t SWEEP_CHUNK_SIZE = 1 << 20;
+
+// an access of a chunk of the trace
+struct SweepAccess {
+    uint32_t address;
+    bool store;
+};
+
+bool readSweepConfigs(const char* filename, bool flat, std::vector<CacheSim>& sims) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Could not read sweep file " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        // split the line into words, skipping blank lines and # comments
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word && word[0] != '#') {
+            words.push_back(word);
+        }
+        if (words.empty()) {
+            continue;
+        }
+        // check them like csim's own arguments (the first being its name)
+        std::vector<char*> args(1, (char*) "csim");
+        for (std::string& w : words) {
+            args.push_back(&w[0]);
+        }
+        if (!validParameters((int) args.size(), args.data())) {
+            std::cerr << "Invalid cache parameters on line " << lineNumber << " of " << filename << std::endl;
+            return false;
+        }
+        // the caches are still empty, so copying them as the vector grows is fine
+        sims.push_back(initializeCacheSim(args.data(), flat));
+    }
+    if (sims.empty()) {
+        std::cerr << "No cache configurations in " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// read up to SWEEP_CHUNK_SIZE accesses of the trace into chunk, returning the status of the last nextAccess
+static int readChunk(TraceReader& reader, std::vector<SweepAccess>& chunk) {
+    chunk.clear();
+    int status = 1;
+    SweepAccess access;
+    while (chunk.size() < SWEEP_CHUNK_SIZE && (status = nextAccess(reader, &access.store, &access.address)) > 0) {
+        chunk.push_back(access);
+    }
+    return status;
+}
+
+// run a chunk through the configurations not yet taken by another thread
+static void simulateChunk(std::vector<CacheSim>& sims, const std::vector<SweepAccess>& chunk, std::atomic<size_t>& next) {
+    size_t i;
+    while ((i = next++) < sims.size()) {
+        for (const SweepAccess& access : chunk) {
+            simulateAccess(sims[i], access.store, access.address);
+        }
+    }
+}
+
+int runSweep(TraceReader& reader, std::vector<CacheSim>& sims, int threads) {
+    // while the threads simulate one chunk, the next one is read
+    std::vector<SweepAccess> chunks[2];
+    chunks[0].reserve(SWEEP_CHUNK_SIZE);
+    chunks[1].reserve(SWEEP_CHUNK_SIZE);
+    int status = readChunk(reader, chunks[0]);
+    for (int current = 0; !chunks[current].empty(); current = 1 - current) {
+        // configurations are handed out one at a time, so threads that get
+        // the quick ones go on to take more
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.push_back(std::thread(simulateChunk, std::ref(sims), std::cref(chunks[current]), std::ref(next)));
+        }
+        if (status > 0) {
+            status = readChunk(reader, chunks[1 - current]);
+        }
+        else {
+            chunks[1 - current].clear();
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        if (status < 0) {
+            break;
+        }
+    }
+    return status;
+}
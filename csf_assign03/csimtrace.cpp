@@ -0,0 +1,252 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "csimfuncs.h"
+
+// size of the buffer traces that can't be mapped are read through (a text
+// line must fit in it)
+static const size_t TRACE_BUFFER_SIZE = 1 << 20;
+
+// longest binary record, in bytes (a TRACE_DELTA varint holds 33 bits)
+static const size_t TRACE_MAX_RECORD_SIZE = 5;
+
+// move the bytes still to be parsed to the start of the buffer and fill the
+// rest of it from the file; returns false on a read error
+static bool refillTrace(TraceReader& reader) {
+    size_t left = reader.size - reader.pos;
+    memmove(reader.buffer.data(), reader.data + reader.pos, left);
+    reader.pos = 0;
+    reader.size = left;
+    while (!reader.eof && reader.size < reader.buffer.size()) {
+        ssize_t n = read(reader.fd, reader.buffer.data() + reader.size, reader.buffer.size() - reader.size);
+        if (n < 0 && errno != EINTR) {
+            return false;
+        }
+        if (n == 0) {
+            reader.eof = true;
+        }
+        else if (n > 0) {
+            reader.size += (size_t) n;
+        }
+    }
+    return true;
+}
+
+bool openTrace(TraceReader& reader, int fd) {
+    reader.fd = fd;
+    reader.pos = 0;
+    reader.binary = false;
+    reader.encoding = TRACE_FIXED;
+    reader.prev_address = 0;
+    reader.count = 0;
+    reader.mapped = false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+    // a file redirected to stdin is mapped too, so "csim ... < trace" gets
+    // the fast path without naming the file
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            // the trace is read front to back, and each page only once
+            madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+            reader.data = (const char*) data;
+            reader.size = (size_t) st.st_size;
+            reader.mapped = true;
+            reader.eof = true;
+        }
+    }
+    if (!reader.mapped) {
+        reader.buffer.resize(TRACE_BUFFER_SIZE);
+        reader.data = reader.buffer.data();
+        reader.size = 0;
+        reader.eof = false;
+        if (!refillTrace(reader)) {
+            return false;
+        }
+    }
+    if (reader.size >= TRACE_HEADER_SIZE && memcmp(reader.data, TRACE_MAGIC, 4) == 0) {
+        unsigned char version = (unsigned char) reader.data[4];
+        unsigned char encoding = (unsigned char) reader.data[5];
+        if (version != TRACE_VERSION || (encoding != TRACE_FIXED && encoding != TRACE_DELTA)) {
+            closeTrace(reader);
+            return false;
+        }
+        reader.binary = true;
+        reader.encoding = encoding;
+        reader.pos = TRACE_HEADER_SIZE;
+    }
+    return true;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// parse the text line from p to end: "l" or "s", then the address in hex
+// (with or without 0x), then anything (the size). Returns 1 for an access,
+// 0 for a blank line or -1 if the line is malformed.
+static int parseTraceLine(const char* p, const char* end, bool* store, uint32_t* address) {
+    while (p < end && isBlank(*p)) {
+        p++;
+    }
+    if (p == end) {
+        return 0;
+    }
+    char op = *p++;
+    if ((op != 'l' && op != 's') || p == end || !isBlank(*p)) {
+        return -1;
+    }
+    while (p < end && isBlank(*p)) {
+        p++;
+    }
+    if (end - p >= 2 && p[0] == '0' && (p[1] | 0x20) == 'x') {
+        p += 2;
+    }
+    // like std::stoul, stop at the first character that isn't a hex digit;
+    // only the low 32 bits of a longer address are kept
+    uint32_t value = 0;
+    int digits = 0;
+    for (int d; p < end && (d = hexDigit(*p)) >= 0; p++, digits++) {
+        value = value << 4 | (uint32_t) d;
+    }
+    if (digits == 0) {
+        return -1;
+    }
+    *store = op == 's';
+    *address = value;
+    return 1;
+}
+
+static int nextTextAccess(TraceReader& reader, bool* store, uint32_t* address) {
+    for (;;) {
+        const char* start = reader.data + reader.pos;
+        const char* end = (const char*) memchr(start, '\n', reader.size - reader.pos);
+        if (end == nullptr && !reader.eof) {
+            // the line goes on past what has been read; a line that
+            // doesn't even fit in the buffer isn't a trace line
+            if (reader.pos == 0 && reader.size == reader.buffer.size()) {
+                return -1;
+            }
+            if (!refillTrace(reader)) {
+                return -1;
+            }
+            continue;
+        }
+        if (end == nullptr) {
+            // the last line need not end with a newline
+            if (reader.pos == reader.size) {
+                return 0;
+            }
+            end = reader.data + reader.size;
+            reader.pos = reader.size;
+        }
+        else {
+            reader.pos = end - reader.data + 1;
+        }
+        reader.count++;
+        int result = parseTraceLine(start, end, store, address);
+        if (result != 0) {
+            return result;
+        }
+    }
+}
+
+static int nextBinaryAccess(TraceReader& reader, bool* store, uint32_t* address) {
+    if (!reader.eof && reader.size - reader.pos < TRACE_MAX_RECORD_SIZE && !refillTrace(reader)) {
+        return -1;
+    }
+    if (reader.pos == reader.size) {
+        return 0;
+    }
+    reader.count++;
+    const unsigned char* p = (const unsigned char*) reader.data + reader.pos;
+    size_t left = reader.size - reader.pos;
+    if (reader.encoding == TRACE_FIXED) {
+        if (left < 5 || p[0] > 1) {
+            return -1;
+        }
+        *store = p[0] == 1;
+        *address = (uint32_t) p[1] | (uint32_t) p[2] << 8 | (uint32_t) p[3] << 16 | (uint32_t) p[4] << 24;
+        reader.pos += 5;
+        return 1;
+    }
+    uint64_t value = 0;
+    size_t len = 0;
+    do {
+        if (len == left || len == TRACE_MAX_RECORD_SIZE) {
+            return -1;
+        }
+        value |= (uint64_t) (p[len] & 0x7f) << (7 * len);
+    } while (p[len++] & 0x80);
+    if (value >> 33 != 0) {
+        return -1;
+    }
+    // undo the zigzag encoding, which keeps small backward steps small
+    uint32_t zigzag = (uint32_t) (value >> 1);
+    uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    *store = (value & 1) != 0;
+    *address = reader.prev_address + delta;
+    reader.prev_address = *address;
+    reader.pos += len;
+    return 1;
+}
+
+int nextAccess(TraceReader& reader, bool* store, uint32_t* address) {
+    return reader.binary ? nextBinaryAccess(reader, store, address) : nextTextAccess(reader, store, address);
+}
+
+void closeTrace(TraceReader& reader) {
+    if (reader.mapped) {
+        munmap((void*) reader.data, reader.size);
+        reader.mapped = false;
+    }
+    reader.data = nullptr;
+    reader.size = reader.pos = 0;
+    std::vector<char>().swap(reader.buffer);
+}
+
+bool initializeTraceWriter(TraceWriter& writer, FILE* out, unsigned char encoding) {
+    writer.out = out;
+    writer.encoding = encoding;
+    writer.prev_address = 0;
+    unsigned char header[TRACE_HEADER_SIZE] = { 'C', 'S', 'T', 'R', TRACE_VERSION, encoding, 0, 0 };
+    return fwrite(header, 1, sizeof(header), out) == sizeof(header);
+}
+
+void writeAccess(TraceWriter& writer, bool store, uint32_t address) {
+    if (writer.encoding == TRACE_FIXED) {
+        unsigned char record[5] = { (unsigned char) store, (unsigned char) address, (unsigned char) (address >> 8),
+                                    (unsigned char) (address >> 16), (unsigned char) (address >> 24) };
+        fwrite(record, 1, sizeof(record), writer.out);
+        return;
+    }
+    // zigzag encode the difference (as a 32-bit signed number) so that small
+    // steps either way give small varints
+    uint32_t delta = address - writer.prev_address;
+    uint32_t zigzag = delta << 1 ^ (0u - (delta >> 31));
+    uint64_t value = (uint64_t) zigzag << 1 | (store ? 1 : 0);
+    while (value >= 0x80) {
+        putc((int) (value & 0x7f) | 0x80, writer.out);
+        value >>= 7;
+    }
+    putc((int) value, writer.out);
+    writer.prev_address = address;
+}
@@ -1,77 +1,163 @@
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <string> 
-#include <sstream>
 #include <cstring>
+#include <vector>
 #include "csimfuncs.h"
 
+// most threads a sweep can use
+const int MAX_SWEEP_THREADS = 256;
+
+// the number of threads given to --threads, or 0 if it isn't valid
+static int parseThreads(const char* input) {
+    char* end = nullptr;
+    long value = strtol(input, &end, 10);
+    if (end == input || *end != '\0' || value < 1 || value > MAX_SWEEP_THREADS) {
+        return 0;
+    }
+    return (int) value;
+}
+
+// read the trace from stdin and run it through the simulations, returning
+// false (after saying why) if it can't be read
+static bool simulateTrace(std::vector<CacheSim>& sims, int threads) {
+    TraceReader trace;
+    if (!openTrace(trace, 0)) {
+        std::cerr << "Could not read the trace" << std::endl;
+        return false;
+    }
+    int status;
+    if (sims.size() == 1) {
+        // read the trace (text or binary) an access at a time
+        bool store;
+        uint32_t address;
+        while ((status = nextAccess(trace, &store, &address)) > 0) {
+            simulateAccess(sims[0], store, address);
+        }
+    }
+    else {
+        status = runSweep(trace, sims, threads);
+    }
+    if (status < 0) {
+        std::cerr << "Malformed trace at " << (trace.binary ? "record " : "line ") << trace.count << std::endl;
+    }
+    closeTrace(trace);
+    return status == 0;
+}
+
+// read the trace from stdin and print its LRU miss ratio curves, for every
+// power of 2 number of sets up to max_sets; returns false if it can't be read
+static bool stackDistanceCurves(int bytes, int max_sets, int max_ways) {
+    std::vector<StackDistances> curves;
+    for (int sets = 1; sets <= max_sets; sets *= 2) {
+        curves.push_back(initializeStackDistances(sets, bytes, max_ways));
+    }
+    TraceReader trace;
+    if (!openTrace(trace, 0)) {
+        std::cerr << "Could not read the trace" << std::endl;
+        return false;
+    }
+    int status = computeStackDistances(trace, curves);
+    if (status < 0) {
+        std::cerr << "Malformed trace at " << (trace.binary ? "record " : "line ") << trace.count << std::endl;
+    }
+    closeTrace(trace);
+    if (status == 0) {
+        printMissRatioCurves(curves);
+    }
+    return status == 0;
+}
+
 int main(int argc, char** argv) {
-    // check that input parameters are valid 
-    if (validParameters(argc, argv)) {
-        // initalize cache parameters
-        int sets = std::stoi(argv[1]);
-        int blocks = std::stoi(argv[2]);
-        int bytes = std::stoi(argv[3]);
-        bool write_allocate = strcmp("write-allocate", argv[4]) == 0 ? true : false;
-        bool write_through = strcmp("write-through", argv[5]) == 0 ? true : false;
-        bool lru = strcmp(argv[6], "lru") == 0 ? true : false;
-        // initalize cache
-        Cache cache = initializeCache(sets, blocks);
-        // initalize simulation counters to zero
-        int load_hits = 0;
-        int load_misses = 0;
-        int store_hits = 0;
-        int store_misses = 0;
-        int total_cycles = 0;
-        std::string input; 
-        // read entire input text 
-        while (std::getline(std::cin, input)) {
-            // create a stream to read 3 sections of each line
-            std::istringstream stream(input);
-            std::string command, address_str;
-            uint32_t address;
-            // separate stream into command and address sections
-            stream >> command >> address_str;
-            // address converted from hex
-            address = std::stoul(address_str, nullptr, 16);
-            // find tag 
-            uint32_t tag = getTag(bytes, address, sets);
-            // find index
-            uint32_t index = getIndex(bytes, address, sets);
-            if (command == "l") {
-                int cycles = cacheLoad(cache, index, tag, bytes, write_through, lru);
-                if (cycles == 1) {
-                    load_hits++;
-                } 
-                else {
-                    load_misses++;
-                }
-                total_cycles += cycles;
-            }
-            else {
-                bool hit = false; 
-                int cycles = cacheStore(cache, index, tag, bytes, write_allocate, write_through, lru, &hit);
-                if (hit) {
-                    store_hits++;
-                }
-                else {
-                    store_misses++;
-                }
-                total_cycles += cycles;
-            }
+    // options before the cache parameters:
+    //   --engine map|flat  simulate with the map-based Cache (the default)
+    //                      or the FlatCache, which gives the same results
+    //   --sweep FILE       simulate every cache configuration in FILE (one
+    //                      line of cache parameters each) over one read of
+    //                      the trace, instead of the one given as arguments
+    //   --threads N        spread the configurations of a sweep over N
+    //                      threads (1 by default)
+    //   --stack-distance BYTES
+    //                      instead of simulating a cache, print the LRU
+    //                      (write-allocate) miss ratio of BYTES-byte blocks
+    //                      for every power of 2 number of sets and blocks
+    //                      per set, up to the two cache parameters if given
+    //                      (4096 and 256 by default), from one pass
+    bool flat = false;
+    const char* sweepFile = nullptr;
+    char* stackBytes = nullptr;
+    int threads = 0;
+    int arg = 1;
+    while (arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0) {
+        if (strcmp(argv[arg], "--engine") == 0 && isValidOption(argv[arg + 1], (char*)"map", (char*)"flat")) {
+            flat = strcmp(argv[arg + 1], "flat") == 0;
         }
-        std::cout << "Total loads: " << (load_hits+load_misses) << std::endl;
-        std::cout << "Total stores: " << (store_hits+store_misses) << std::endl;
-        std::cout << "Load hits: " << load_hits << std::endl;
-        std::cout << "Load misses: " << load_misses << std::endl;
-        std::cout << "Store hits: " << store_hits << std::endl;
-        std::cout << "Store misses: " << store_misses << std::endl;
-        std::cout << "Total cycles: " << total_cycles << std::endl;
-        return 0;
+        else if (strcmp(argv[arg], "--sweep") == 0) {
+            sweepFile = argv[arg + 1];
+        }
+        else if (strcmp(argv[arg], "--stack-distance") == 0 && isByteValid(argv[arg + 1])) {
+            stackBytes = argv[arg + 1];
+        }
+        else if (strcmp(argv[arg], "--threads") == 0 && parseThreads(argv[arg + 1]) > 0) {
+            threads = parseThreads(argv[arg + 1]);
+        }
+        else {
+            std::cerr << "Unknown option " << argv[arg] << " " << argv[arg + 1] << std::endl;
+            return 1;
+        }
+        arg += 2;
+    }
+    // the cache parameters are checked as if they were the only arguments
+    argc -= arg - 1;
+    argv += arg - 1;
+    if (stackBytes != nullptr) {
+        if (sweepFile != nullptr || threads != 0) {
+            std::cerr << "--stack-distance can't be used with --sweep or --threads" << std::endl;
+            return 1;
+        }
+        if (argc != 1 && (argc != 3 || !isSetAndBlockValid(argv[1], argv[2]))) {
+            std::cerr << "Please enter a positive power of 2 for the most sets and blocks per set, or neither" << std::endl;
+            return 1;
+        }
+        return stackDistanceCurves(std::stoi(stackBytes), argc == 3 ? std::stoi(argv[1]) : 4096,
+                                   argc == 3 ? std::stoi(argv[2]) : 256) ? 0 : 1;
+    }
+    std::vector<CacheSim> sims;
+    if (sweepFile != nullptr) {
+        if (argc != 1) {
+            std::cerr << "With --sweep, the cache parameters come from the sweep file" << std::endl;
+            return 1;
+        }
+        if (!readSweepConfigs(sweepFile, flat, sims)) {
+            return 1;
+        }
+    }
+    else if (threads != 0) {
+        std::cerr << "--threads can only be used with --sweep" << std::endl;
+        return 1;
+    }
+    // check that input parameters are valid 
+    else if (validParameters(argc, argv)) {
+        sims.push_back(initializeCacheSim(argv, flat));
     }
     else {
         // error messages dealt with in valid parameters function, just need to return non zero exit code
         return 1;
     }
+    if (!simulateTrace(sims, threads > 0 ? threads : 1)) {
+        return 1;
+    }
+    for (size_t i = 0; i < sims.size(); i++) {
+        const CacheSim& sim = sims[i];
+        // a sweep labels each block of statistics with its configuration
+        if (sweepFile != nullptr) {
+            std::cout << (i > 0 ? "\n" : "") << "Cache: " << sim.sets << " " << sim.blocks << " " << sim.bytes << " "
+                      << (sim.write_allocate ? "write-allocate " : "no-write-allocate ")
+                      << (sim.write_through ? "write-through " : "write-back ")
+                      << (sim.lru ? "lru" : "fifo") << std::endl;
+        }
+        printStats(sim.stats);
+    }
+    return 0;
 }
-